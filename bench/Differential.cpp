@@ -0,0 +1,82 @@
+#include "Differential.hpp"
+#include "Game/Engine.hpp"
+
+#include <fmt/core.h>
+
+/* worlds both engines are compared on */
+struct DifferentialWorld
+{
+	const char* name;
+	unsigned int w, h;
+	unsigned int spacing;
+};
+
+static const DifferentialWorld differential_worlds[] = {
+	{"sparse", 200, 50, 10},
+	{"dense", 120, 40, 2},
+	{"narrow", 16, 60, 3},
+};
+
+static std::string describe(const game::Tile& tile)
+{
+	static const char* kinds[] = {"empty", "active", "dead", "seed"};
+	if (tile.kind == game::Tile::Kind::EMPTY)
+		return "empty";
+	return fmt::format("{} gene {} energy {} age {}", kinds[static_cast<int>(tile.kind)],
+					   tile.activeGene, tile.energy, tile.age);
+}
+
+/* report first tile which differs, rows from the ground up */
+static void report_divergence(const game::Engine& a, const game::Engine& b)
+{
+	for (unsigned int y = 0; y < a.height(); y++)
+		for (unsigned int x = 0; x < a.width(); x++)
+		{
+			auto ta = a.tile({x, y}), tb = b.tile({x, y});
+			if (ta != tb)
+			{
+				fmt::print("  first differing tile ({}, {}): {}: {}; {}: {}\n", x, y,
+						   a.name(), describe(ta), b.name(), describe(tb));
+				return;
+			}
+		}
+	fmt::print("  tiles are equal, hashes differ\n");
+}
+
+int run_differential(const std::string& reference, const std::string& candidate, int ticks, unsigned int seed)
+{
+	int failures = 0;
+	for (auto& world : differential_worlds)
+	{
+		game::Parameters params;
+		params.seed = seed;
+		auto a = game::make_engine(reference, world.w, world.h, params);
+		auto b = game::make_engine(candidate, world.w, world.h, params);
+		for (unsigned int x = world.spacing / 2; x < world.w; x += world.spacing)
+		{
+			a->spawn(x);
+			b->spawn(x);
+		}
+
+		int tick = 0;
+		bool diverged = a->hash() != b->hash();
+		while (!diverged && tick < ticks)
+		{
+			bool aliveA = a->tick(), aliveB = b->tick();
+			tick++;
+			diverged = aliveA != aliveB || a->hash() != b->hash();
+			if (!aliveA && !diverged)
+				break;
+		}
+		if (diverged)
+		{
+			failures++;
+			fmt::print("{:<8} {} and {} diverged at tick {}\n", world.name, reference, candidate, tick);
+			report_divergence(*a, *b);
+		}
+		else
+			fmt::print("{:<8} {} and {} agree for {} ticks, hash {:016x}\n", world.name, reference, candidate,
+					   tick, a->hash());
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+/**
+ * @brief Run engines @a reference and @a candidate side by side from the
+ * same seed and compare hashes of their worlds after every tick.
+ * @detail On the first mismatch the first differing tile (bottom row first)
+ * of both engines is printed.
+ * @return 0 if engines agreed for all @a ticks ticks, 1 otherwise.
+ * @throw std::invalid_argument if an engine is unknown.
+ */
+int run_differential(const std::string& reference, const std::string& candidate, int ticks, unsigned int seed);
@@ -0,0 +1,225 @@
+#include "Regression.hpp"
+#include "Game/Statistics.hpp"
+#include "Game/World.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <entt/entity/registry.hpp>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+using nlohmann::json;
+
+/* speed may drop and peak memory may grow by this fraction before a scenario fails */
+constexpr double default_speed_tolerance = 0.10;
+constexpr double default_memory_tolerance = 0.10;
+/* timed runs of every scenario, the fastest one counts */
+constexpr int repetitions = 5;
+
+/* trees planted every `spacing` columns live `warmup` ticks untimed, then `ticks` ticks are timed */
+struct RegressionScenario
+{
+	const char* name;
+	unsigned int w, h;
+	unsigned int spacing;
+	game::Parameters params;
+	int warmup;
+	int ticks;
+};
+
+static const RegressionScenario regression_scenarios[] = {
+	/* few young trees in a big world */
+	{"sparse-seedlings", 400, 60, 40, {.seed = 1}, 0, 200},
+	/* crowded mature forest */
+	{"dense-forest", 300, 60, 3, {.seed = 2}, 300, 300},
+	/* all trees reach their max age at once and turn into seeds */
+	{"mass-death", 300, 60, 2, {.minMaxAge = 60, .maxMaxAge = 60, .seed = 3}, 50, 40},
+	/* tall trees die together, seeds fall through the whole world */
+	{"seed-rain", 200, 150, 4, {.minSun = 15, .minMaxAge = 120, .maxMaxAge = 120, .seed = 4}, 110, 60},
+};
+
+struct Measurement
+{
+	double ticksPerSecond = 0.0;
+	std::size_t peakRss = 0;
+	game::Statistics outcome;
+};
+
+static Measurement measure_scenario(const RegressionScenario& scenario)
+{
+	using clock = std::chrono::steady_clock;
+	Measurement measurement;
+	for (int i = 0; i < repetitions; i++)
+	{
+		entt::registry registry;
+		game::World world{registry, scenario.w, scenario.h, scenario.params};
+		for (unsigned int x = scenario.spacing / 2; x < world.w; x += scenario.spacing)
+			game::Tree::spawn(world, x);
+		for (int tick = 0; tick < scenario.warmup; tick++)
+			world.tick();
+		const auto start = clock::now();
+		for (int tick = 0; tick < scenario.ticks; tick++)
+			world.tick();
+		const std::chrono::duration<double> elapsed = clock::now() - start;
+		measurement.ticksPerSecond = std::max(measurement.ticksPerSecond,
+											  scenario.ticks / std::max(elapsed.count(), 1e-9));
+		measurement.outcome = game::gather_statistics(world);
+	}
+	return measurement;
+}
+
+/* measure scenario in a child process, its peak RSS is then scenario's alone */
+static bool measure_isolated(const RegressionScenario& scenario, Measurement& measurement)
+{
+	int fds[2];
+	if (pipe(fds) != 0)
+		return false;
+	pid_t pid = fork();
+	if (pid < 0)
+		return false;
+	if (pid == 0)
+	{
+		close(fds[0]);
+		Measurement result = measure_scenario(scenario);
+		bool written = write(fds[1], &result, sizeof(result)) == sizeof(result);
+		_exit(written ? 0 : 1);
+	}
+	close(fds[1]);
+	bool received = read(fds[0], &measurement, sizeof(measurement)) == sizeof(measurement);
+	close(fds[0]);
+	int status = 0;
+	rusage usage{};
+	if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		return false;
+	measurement.peakRss = static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+	return received;
+}
+
+static json to_baseline(const Measurement& measurement)
+{
+	return json{{"ticks_per_second", measurement.ticksPerSecond},
+				{"peak_rss", measurement.peakRss},
+				{"trees", measurement.outcome.trees},
+				{"seeds", measurement.outcome.seeds},
+				{"cells", measurement.outcome.cells},
+				{"energy", measurement.outcome.energy}};
+}
+
+/* compiler, standard library and cell memory this was built with */
+static std::string build_name()
+{
+#if defined(__clang__)
+	std::string name = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	std::string name = "gcc " __VERSION__;
+#else
+	std::string name = "unknown compiler";
+#endif
+#if defined(_LIBCPP_VERSION)
+	name += fmt::format(", libc++ {}", _LIBCPP_VERSION);
+#elif defined(_GLIBCXX_RELEASE)
+	name += fmt::format(", libstdc++ {}", _GLIBCXX_RELEASE);
+#endif
+	return name + fmt::format(", {} cell memory", game::CellMemory::name);
+}
+
+static void print_row(const RegressionScenario& scenario, const Measurement& measurement,
+					  const std::string (&speed)[2], const std::string (&rss)[2], const char* result)
+{
+	fmt::print("{:<18} {:>10.0f} {:>10} {:>8} {:>10} {:>10} {:>8}  {}\n", scenario.name,
+			   measurement.ticksPerSecond, speed[0], speed[1], measurement.peakRss / 1024, rss[0], rss[1], result);
+}
+
+int run_regression(const std::string& baselinePath, bool update)
+{
+	json baselines = json::object();
+	if (std::ifstream in{baselinePath})
+		in >> baselines;
+	else if (!update)
+	{
+		fmt::print(stderr, "No baselines in {}, record them on this machine with\n"
+				   "  cursed-trees-bench --regress {} --update\n", baselinePath, baselinePath);
+		return 1;
+	}
+	const double speedTolerance = baselines.value("speed_tolerance", default_speed_tolerance);
+	const double memoryTolerance = baselines.value("memory_tolerance", default_memory_tolerance);
+	/* World::random's distributions are implementation-defined and so are outcomes, speed
+	   and memory depend on compiler and cell memory, so every build has baselines of its own */
+	const std::string build = build_name();
+	json& recorded = baselines["builds"][build];
+	if (!update && recorded.is_null())
+	{
+		fmt::print(stderr, "No baselines for {} in {}, record them with\n"
+				   "  cursed-trees-bench --regress {} --update\n", build, baselinePath, baselinePath);
+		return 1;
+	}
+
+	fmt::print("Build: {}\n", build);
+	fmt::print("{:<18} {:>10} {:>10} {:>8} {:>10} {:>10} {:>8}  {}\n", "scenario", "ticks/s", "baseline",
+			   "change", "RSS KiB", "baseline", "change", "result");
+	int failures = 0;
+	for (auto& scenario : regression_scenarios)
+	{
+		Measurement measurement;
+		if (!measure_isolated(scenario, measurement))
+		{
+			fmt::print("{:<18} failed to run\n", scenario.name);
+			failures++;
+			continue;
+		}
+		if (update)
+		{
+			recorded[scenario.name] = to_baseline(measurement);
+			print_row(scenario, measurement, {"-", "-"}, {"-", "-"}, "recorded");
+			continue;
+		}
+
+		const json& baseline = recorded.contains(scenario.name) ? recorded[scenario.name] : json::object();
+		if (!baseline.contains("ticks_per_second") || !baseline.contains("peak_rss") ||
+			!baseline.contains("trees"))
+		{
+			print_row(scenario, measurement, {"-", "-"}, {"-", "-"}, "NO BASELINE, record it with --update");
+			failures++;
+			continue;
+		}
+		const double baseSpeed = baseline["ticks_per_second"];
+		const std::size_t baseRss = baseline["peak_rss"];
+		const double speedChange = measurement.ticksPerSecond / std::max(baseSpeed, 1e-9) - 1.0;
+		const double rssChange = double(measurement.peakRss) / std::max<std::size_t>(baseRss, 1) - 1.0;
+		const char* result = "ok";
+		if (baseline["trees"] != measurement.outcome.trees || baseline["seeds"] != measurement.outcome.seeds ||
+			baseline["cells"] != measurement.outcome.cells || baseline["energy"] != measurement.outcome.energy)
+			result = "OUTCOME CHANGED";
+		else if (speedChange < -speedTolerance)
+			result = "SLOWER";
+		else if (rssChange > memoryTolerance)
+			result = "MORE MEMORY";
+		if (std::string_view(result) != "ok")
+			failures++;
+		print_row(scenario, measurement,
+				  {fmt::format("{:.0f}", baseSpeed), fmt::format("{:+.1f}%", speedChange * 100.0)},
+				  {fmt::format("{}", baseRss / 1024), fmt::format("{:+.1f}%", rssChange * 100.0)}, result);
+	}
+
+	if (update)
+	{
+		baselines["speed_tolerance"] = speedTolerance;
+		baselines["memory_tolerance"] = memoryTolerance;
+		std::ofstream out{baselinePath};
+		if (!out)
+		{
+			fmt::print(stderr, "Can't write {}\n", baselinePath);
+			return 1;
+		}
+		out << baselines.dump(2) << '\n';
+	}
+	if (failures)
+		fmt::print("{} of {} scenarios failed.\n", failures, std::size(regression_scenarios));
+	return failures ? 1 : 0;
+}
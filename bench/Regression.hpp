@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+/**
+ * @brief Run fixed-seed scenarios and compare their speed, peak memory and
+ * outcome with baselines stored in @a baselinePath.
+ * @detail Every scenario runs in its own child process so peak RSS of one
+ * doesn't leak into another. Baselines are kept per compiler, standard
+ * library and cell memory. Only with @a update the file is written, then
+ * baselines of this build are replaced with the measured values.
+ * @return 0 if nothing regressed, 1 otherwise or if this build has no
+ * baselines in the file.
+ */
+int run_regression(const std::string& baselinePath, bool update);
@@ -0,0 +1,296 @@
+
+#include "Game/Renderer.hpp"
+#include "Game/Serialization.hpp"
+#include "Game/Engine.hpp"
+#include "Game/World.hpp"
+#include "Differential.hpp"
+#include "Regression.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <entt/entity/registry.hpp>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+/// allocation counting
+static std::size_t allocations = 0;
+
+void* operator new(std::size_t size)
+{
+	allocations++;
+	if (void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+/* World with trees planted every `spacing` columns which lived for `warmup` years */
+struct Scenario
+{
+	const char* name;
+	unsigned int w, h;
+	unsigned int spacing;
+	int warmup;
+};
+
+constexpr Scenario scenarios[] = {
+	{"small-sparse", 100, 30, 20, 100},
+	{"small-dense", 100, 30, 2, 100},
+	{"medium-sparse", 200, 50, 20, 200},
+	{"medium-dense", 200, 50, 2, 200},
+	{"large-dense", 800, 100, 2, 200},
+};
+
+constexpr unsigned int seed = 12345;
+constexpr int samples = 5;
+
+struct Fixture
+{
+	entt::registry registry;
+	game::World world;
+
+	Fixture(const Scenario& scenario)
+		: world(registry, scenario.w, scenario.h, game::Parameters{.seed = seed})
+	{
+		for (unsigned int x = scenario.spacing / 2; x < world.w; x += scenario.spacing)
+			game::Tree::spawn(world, x);
+		for (int i = 0; i < scenario.warmup; i++)
+			world.tick();
+	}
+
+	std::vector<entt::entity> livingTrees()
+	{
+		std::vector<entt::entity> trees;
+		for (auto entity : registry.view<game::Tree, game::Living>())
+			trees.push_back(entity);
+		return trees;
+	}
+};
+
+/* Displayer for game::Renderer which draws nothing */
+struct NullDisplayer
+{
+	int w = 0, h = 0;
+	unsigned long long checksum = 0;
+
+	int width() const { return w; }
+	int height() const { return h; }
+	void begin() {}
+	void end() {}
+	void draw(unsigned y, unsigned x, char ch, unsigned color) { checksum += x + y + ch + color; }
+	void onScroll() {}
+};
+
+/* amount of work done by one call of benchmark's body */
+struct Work
+{
+	std::size_t ops = 0;
+	std::size_t cells = 0;
+};
+
+struct Result
+{
+	double nsPerOp = 0.0;
+	double cellsPerSec = 0.0;
+	double allocsPerOp = 0.0;
+};
+
+/* Run `body` on a fresh fixture `samples` times, report the fastest sample */
+template<typename F>
+Result measure(const Scenario& scenario, F&& body)
+{
+	using clock = std::chrono::steady_clock;
+	Result best{.nsPerOp = 1e300};
+	for (int i = 0; i < samples; i++)
+	{
+		Fixture fixture{scenario};
+		const auto allocsBefore = allocations;
+		const auto start = clock::now();
+		Work work = body(fixture);
+		const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+		const auto allocs = allocations - allocsBefore;
+		if (work.ops == 0)
+			return {};
+		if (ns / work.ops < best.nsPerOp)
+		{
+			best.nsPerOp = ns / work.ops;
+			best.cellsPerSec = work.cells / (ns * 1e-9);
+			best.allocsPerOp = double(allocs) / work.ops;
+		}
+	}
+	return best;
+}
+
+static std::size_t cells_of(const game::Tree& tree)
+{
+	return tree.aliveCells.size() + tree.deadCells.size();
+}
+
+struct Benchmark
+{
+	const char* name;
+	Work (*body)(Fixture&);
+};
+
+constexpr int repeats = 20;
+
+constexpr Benchmark benchmarks[] = {
+	{"World::tick", [](Fixture& f) {
+		Work work{repeats, 0};
+		for (int i = 0; i < repeats; i++)
+		{
+			work.cells += f.registry.size<game::Cell>();
+			f.world.tick();
+		}
+		return work;
+	}},
+	{"World::sun", [](Fixture& f) {
+		Work work{repeats, repeats * f.registry.size<game::Cell>()};
+		for (int i = 0; i < repeats; i++)
+			f.world.sun();
+		return work;
+	}},
+	{"World::physics", [](Fixture& f) {
+		Work work{repeats, 0};
+		for (int i = 0; i < repeats; i++)
+		{
+			work.cells += f.registry.size<game::Falling>();
+			f.world.physics();
+		}
+		return work;
+	}},
+	{"World::growTrees", [](Fixture& f) {
+		Work work{repeats, 0};
+		for (int i = 0; i < repeats; i++)
+		{
+			work.cells += f.registry.size<game::Cell>();
+			f.world.growTrees();
+		}
+		return work;
+	}},
+	{"Tree::grow", [](Fixture& f) {
+		Work work;
+		for (auto entity : f.livingTrees())
+		{
+			work.ops++;
+			work.cells += f.registry.get<game::Tree>(entity).aliveCells.size();
+			game::Tree::grow(f.world, entity);
+		}
+		return work;
+	}},
+	{"Tree::kill", [](Fixture& f) {
+		Work work;
+		for (auto entity : f.livingTrees())
+		{
+			work.ops++;
+			work.cells += cells_of(f.registry.get<game::Tree>(entity));
+			game::Tree::kill(f.world, entity);
+		}
+		return work;
+	}},
+	/* every tree dies at once and its seeds fall through the world, most of them land on cells and die */
+	{"seed rain", [](Fixture& f) {
+		Work work;
+		for (auto entity : f.livingTrees())
+		{
+			work.ops++;
+			work.cells += cells_of(f.registry.get<game::Tree>(entity));
+			game::Tree::kill(f.world, entity);
+		}
+		for (unsigned int i = 0; i < f.world.h; i++)
+			f.world.tick();
+		return work;
+	}},
+	{"Genom::clone", [](Fixture& f) {
+		constexpr std::size_t clones = 100000;
+		game::Genom genom{f.world.random};
+		for (std::size_t i = 0; i < clones; i++)
+			genom = genom.clone(f.world.random, f.world.params.mutationChance);
+		return Work{clones, 0};
+	}},
+	{"Renderer::render", [](Fixture& f) {
+		game::Renderer<NullDisplayer> renderer{f.world, NullDisplayer{int(f.world.w), int(f.world.h)}};
+		for (int i = 0; i < repeats; i++)
+			renderer.render(i & 1);
+		if (renderer.checksum == 0) /* keep the compiler from throwing rendering away */
+			fmt::print("");
+		return Work{repeats, repeats * std::size_t(f.world.w * f.world.h)};
+	}},
+	{"serialize_tree", [](Fixture& f) {
+		Work work;
+		std::size_t size = 0;
+		for (auto entity : f.livingTrees())
+		{
+			work.ops++;
+			work.cells += cells_of(f.registry.get<game::Tree>(entity));
+			size += game::serialize_tree(f.world, entity).size();
+		}
+		if (size == 0)
+			fmt::print("");
+		return work;
+	}},
+};
+
+int main(int argc, char** argv)
+{
+	/* --regress [perf-baseline.json] [--update] compares fixed-seed scenarios with stored baselines */
+	if (argc > 1 && std::string_view(argv[1]) == "--regress")
+	{
+		std::string baseline = "perf-baseline.json";
+		bool update = false;
+		for (int i = 2; i < argc; i++)
+		{
+			if (std::string_view(argv[i]) == "--update") update = true;
+			else baseline = argv[i];
+		}
+		return run_regression(baseline, update);
+	}
+	/* --diff [reference] [candidate] [ticks] [seed] checks that two engines give equal worlds */
+	if (argc > 1 && std::string_view(argv[1]) == "--diff")
+	{
+		try
+		{
+			return run_differential(argc > 2 ? argv[2] : "reference", argc > 3 ? argv[3] : "optimized",
+									argc > 4 ? std::stoi(argv[4]) : 1000,
+									argc > 5 ? static_cast<unsigned int>(std::stoul(argv[5])) : seed);
+		}
+		catch (const std::logic_error& e)
+		{
+			fmt::print(stderr, "{}\nEngines:", e.what());
+			for (auto& name : game::engine_names())
+				fmt::print(stderr, " {}", name);
+			fmt::print(stderr, "\n");
+			return 1;
+		}
+	}
+	/* optional argument: run only benchmarks and scenarios whose names contain it */
+	std::string_view filter = argc > 1 ? argv[1] : "";
+	fmt::print("Cell memory: {}\n", game::CellMemory::name);
+	fmt::print("{:<18} {:<14} {:>14} {:>14} {:>12}\n", "benchmark", "world", "ns/op", "Mcells/s", "allocs/op");
+	for (auto& benchmark : benchmarks)
+		for (auto& scenario : scenarios)
+		{
+			if (std::string_view(benchmark.name).find(filter) == std::string_view::npos &&
+				std::string_view(scenario.name).find(filter) == std::string_view::npos)
+				continue;
+			auto result = measure(scenario, benchmark.body);
+			fmt::print("{:<18} {:<14} {:>14.1f} {:>14.2f} {:>12.1f}\n", benchmark.name, scenario.name,
+					   result.nsPerOp, result.cellsPerSec * 1e-6, result.allocsPerOp);
+		}
+	return 0;
+}
@@ -0,0 +1,136 @@
+
+#include "Game/Lineage.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <fmt/core.h>
+
+namespace
+{
+	constexpr std::string_view death_names[] = {"seed", "destroyed", "old"};
+
+	struct Life
+	{
+		std::uint64_t parent = 0;
+		unsigned int born = 0;
+		/* -1 while it's a seed */
+		long long planted = -1;
+		int mutatedGene = -1;
+		std::uint64_t genom = 0;
+	};
+
+	void print_tree(std::uint64_t id, const Life& life, std::string_view died, std::string_view cause)
+	{
+		fmt::print("{},{},{},{},{},{},{},{:016x}\n", id, life.parent, life.born,
+				   life.planted < 0 ? std::string() : std::to_string(life.planted), died, cause,
+				   life.mutatedGene < 0 ? std::string() : std::to_string(life.mutatedGene), life.genom);
+	}
+
+	/* one line per tree in order of death, trees alive at the end come last */
+	void print_family(game::LineageReader& reader)
+	{
+		std::unordered_map<std::uint64_t, Life> alive;
+		game::LineageEvent event;
+		fmt::print("id,parent,born,planted,died,cause,mutated_gene,genom\n");
+		while (reader.next(event))
+			switch (event.type)
+			{
+			case game::LineageEvent::Type::FOUNDER:
+				alive[event.id] = Life{0, event.year, event.year, -1, event.genom.hash()};
+				break;
+			case game::LineageEvent::Type::SEED:
+				alive[event.id] = Life{event.parent, event.year, -1,
+									   event.mutatedGene < game::Genom::num_genes ? event.mutatedGene : -1,
+									   event.genom.hash()};
+				break;
+			case game::LineageEvent::Type::PLANT:
+				alive[event.id].planted = event.year;
+				break;
+			case game::LineageEvent::Type::DEATH:
+			{
+				auto it = alive.find(event.id);
+				print_tree(event.id, it->second, std::to_string(event.year), death_names[static_cast<int>(event.cause)]);
+				alive.erase(it);
+				break;
+			}
+			}
+		for (auto& [id, life] : alive)
+			print_tree(id, life, "", "");
+	}
+
+	/* distinct genoms of planted trees after every year which had births or deaths */
+	void print_species(game::LineageReader& reader)
+	{
+		/* genom hash -> number of planted trees with it */
+		std::unordered_map<std::uint64_t, unsigned int> species;
+		std::unordered_set<std::uint64_t> seen;
+		std::unordered_map<std::uint64_t, std::uint64_t> planted;
+		unsigned int year = 0, appeared = 0, extinct = 0;
+		bool any = false;
+		auto flush = [&]() {
+			fmt::print("{},{},{},{},{}\n", year, species.size(), planted.size(), appeared, extinct);
+			appeared = extinct = 0;
+		};
+		game::LineageEvent event;
+		fmt::print("year,species,living,new_species,extinct_species\n");
+		while (reader.next(event))
+		{
+			if (any && event.year != year)
+				flush();
+			any = true;
+			year = event.year;
+			const auto hash = event.genom.hash();
+			if (event.type == game::LineageEvent::Type::FOUNDER || event.type == game::LineageEvent::Type::PLANT)
+			{
+				planted.emplace(event.id, hash);
+				if (species[hash]++ == 0 && seen.insert(hash).second)
+					appeared++;
+			}
+			else if (event.type == game::LineageEvent::Type::DEATH && planted.erase(event.id))
+			{
+				auto it = species.find(hash);
+				if (--it->second == 0)
+				{
+					species.erase(it);
+					extinct++;
+				}
+			}
+		}
+		if (any)
+			flush();
+	}
+}
+
+/* rebuild family tree or history of species from a log written with `cursed-trees --lineage file` */
+int main(int argc, char** argv)
+{
+	std::string_view mode = argc > 2 ? argv[1] : "";
+	if (argc < 2 || argc > 3 || (argc == 3 && mode != "--species") ||
+		std::string_view(argv[1]) == "-h" || std::string_view(argv[1]) == "--help")
+	{
+		fmt::print("usage: {} [--species] file\n"
+				   "Print every tree of a lineage log in csv format: id, parent (0 for founders),\n"
+				   "years it was born, planted and died, cause of death, gene which mutated\n"
+				   "and hash of its genom. With --species print number of species, living trees,\n"
+				   "new and extinct species after every year instead.\n", argv[0]);
+		return argc == 2 ? 0 : 1;
+	}
+	try
+	{
+		game::LineageReader reader{argv[argc - 1]};
+		if (mode == "--species")
+			print_species(reader);
+		else
+			print_family(reader);
+	}
+	catch (const std::runtime_error& e)
+	{
+		fmt::print(stderr, "{}\n", e.what());
+		return 1;
+	}
+	return 0;
+}
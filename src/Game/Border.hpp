@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Genetic.hpp"
+
+#include <type_traits>
+#include <vector>
+
+namespace game
+{
+	class World;
+
+	/**
+	 * @brief Cell which grew across an edge of a stripe, it becomes a tree of
+	 * its own in the neighbouring stripe, see Tree::bud.
+	 */
+	struct Bud
+	{
+		unsigned int y = 0;
+		byte activeGene = 0;
+		/* energy taken from the tree it grew from */
+		int energy = 0;
+		int age = 0;
+		int maxAge = 0;
+		Genom genom;
+	};
+	/* buds are sent between processes as they are */
+	static_assert(std::is_trivially_copyable_v<Bud>);
+
+	/**
+	 * @brief Left and right edges of a world which is a vertical stripe of a
+	 * wider world simulated by other processes, see World::border.
+	 * @detail With a border set World doesn't wrap around. Trees never span
+	 * stripes: growth across an edge checks the neighbour's edge column and
+	 * leaves a Bud for it instead. World::tick() exchanges edge columns
+	 * after physics and buds after growth, so neighbouring stripes tick at
+	 * the same time and wait for each other only twice a tick.
+	 * A bud takes its tile only if the tile is still empty after growth of
+	 * the stripe it grew into, buds from the left are grafted before ones
+	 * from the right and each side's in the order they grew, so a run
+	 * doesn't depend on timing of the processes.
+	 */
+	class Border
+	{
+	public:
+		enum Side
+		{
+			LEFT, RIGHT
+		};
+
+		/* neighbours' edge columns after the last exchange, true where a tile is occupied */
+		std::vector<bool> occupied[2];
+		/* buds for neighbours grown since the last exchange */
+		std::vector<Bud> buds[2];
+		/* buds neighbours sent for this world's edge columns */
+		std::vector<Bud> received[2];
+
+		explicit Border(unsigned int h)
+			: occupied{std::vector<bool>(h), std::vector<bool>(h)}
+		{
+
+		}
+		virtual ~Border() = default;
+
+		/* send edge columns of @a world to neighbours and fill occupied with theirs */
+		virtual void exchangeEdges(const World& world) = 0;
+		/* send buds to neighbours, clear them and fill received with neighbours' ones */
+		virtual void exchangeBuds(const World& world) = 0;
+	};
+}
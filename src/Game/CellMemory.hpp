@@ -0,0 +1,207 @@
+#pragma once
+
+#include "Components.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <list>
+#if defined(CURSED_TREES_CELL_MEMORY_PMR) || defined(CURSED_TREES_CELL_MEMORY_ARENA)
+#define CURSED_TREES_CELL_MEMORY_SHARED
+#include <memory_resource>
+#else
+#include <lida/MemoryPool.hpp>
+#endif
+
+namespace game
+{
+#ifdef CURSED_TREES_CELL_MEMORY_SHARED
+	/* upstream of cell memory, counts bytes it got from new and delete */
+	class CountingResource : public std::pmr::memory_resource
+	{
+	public:
+		std::size_t bytes = 0;
+
+	private:
+		void* do_allocate(std::size_t size, std::size_t alignment) override
+		{
+			void* p = std::pmr::new_delete_resource()->allocate(size, alignment);
+			bytes += size;
+			return p;
+		}
+		void do_deallocate(void* p, std::size_t size, std::size_t alignment) override
+		{
+			std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+			bytes -= size;
+		}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+	};
+#endif
+
+#ifdef CURSED_TREES_CELL_MEMORY_ARENA
+	/* passes nodes of lists through to @a upstream, counts how many of them lists hold */
+	class NodeCounter : public std::pmr::memory_resource
+	{
+	public:
+		std::size_t nodes = 0;
+
+		explicit NodeCounter(std::pmr::memory_resource* upstream) : upstream(upstream) {}
+
+	private:
+		std::pmr::memory_resource* upstream;
+
+		void* do_allocate(std::size_t size, std::size_t alignment) override
+		{
+			void* p = upstream->allocate(size, alignment);
+			nodes++;
+			return p;
+		}
+		void do_deallocate(void* p, std::size_t size, std::size_t alignment) override
+		{
+			upstream->deallocate(p, size, alignment);
+			nodes--;
+		}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+	};
+#endif
+
+	/**
+	 * @brief Memory of trees' aliveCells and deadCells lists.
+	 * @detail Policy is chosen at compile time by CMake option
+	 * CURSED_TREES_CELL_MEMORY:
+	 *   pool - every list owns a lida::MemoryPool, the default;
+	 *   pmr - lists of a world share std::pmr::unsynchronized_pool_resource;
+	 *   arena - lists of a world take nodes from slabs of
+	 *     std::pmr::monotonic_buffer_resource. Nodes of dead trees are
+	 *     spliced to a list of spare ones in O(1) and reused by new cells.
+	 *     Once every node is spare, that is no tree has cells left, slabs
+	 *     are freed all at once and the next generation starts from fresh
+	 *     ones, otherwise they are kept until the world is destroyed.
+	 * Every world owns one. Lists of a world must be created and changed
+	 * through it, so nodes can be moved between them and reused.
+	 */
+	class CellMemory
+	{
+	public:
+#ifdef CURSED_TREES_CELL_MEMORY_SHARED
+		using List = std::pmr::list<Vector2>;
+#else
+		using List = std::list<Vector2, lida::MemoryPool<Vector2>>;
+#endif
+
+		CellMemory() = default;
+		CellMemory(const CellMemory&) = delete;
+		CellMemory& operator=(const CellMemory&) = delete;
+
+		/* empty list taking memory from here */
+		List list()
+		{
+#if defined(CURSED_TREES_CELL_MEMORY_PMR)
+			return List(&pool);
+#elif defined(CURSED_TREES_CELL_MEMORY_ARENA)
+			return List(&counter);
+#else
+			return List();
+#endif
+		}
+
+		void push_back(List& list, Vector2 pos)
+		{
+#ifdef CURSED_TREES_CELL_MEMORY_ARENA
+			if (!spare.empty())
+			{
+				list.splice(list.end(), spare, spare.begin());
+				list.back() = pos;
+				return;
+			}
+#endif
+			list.push_back(pos);
+		}
+
+		void push_front(List& list, Vector2 pos)
+		{
+#ifdef CURSED_TREES_CELL_MEMORY_ARENA
+			if (!spare.empty())
+			{
+				list.splice(list.begin(), spare, spare.begin());
+				list.front() = pos;
+				return;
+			}
+#endif
+			list.push_front(pos);
+		}
+
+		/* move node at @a it to the end of @a to, returns the node after it */
+		List::iterator move(List& from, List::iterator it, List& to)
+		{
+#ifdef CURSED_TREES_CELL_MEMORY_SHARED
+			auto next = std::next(it);
+			to.splice(to.end(), from, it);
+			return next;
+#else
+			to.push_back(*it);
+			return from.erase(it);
+#endif
+		}
+
+		/* free all nodes of @a list, O(1) with arena unless it frees the slabs */
+		void release(List& list)
+		{
+#ifdef CURSED_TREES_CELL_MEMORY_ARENA
+			spare.splice(spare.end(), list);
+			if (spare.size() == counter.nodes)
+			{
+				spare.clear();
+				arena.release();
+			}
+#else
+			list.clear();
+#endif
+		}
+
+		/* bytes taken from the system, 0 when every list owns its memory */
+		std::size_t reservedBytes() const
+		{
+#ifdef CURSED_TREES_CELL_MEMORY_SHARED
+			return upstream.bytes;
+#else
+			return 0;
+#endif
+		}
+
+		/* value of CURSED_TREES_CELL_MEMORY this was built with */
+		static constexpr const char* name =
+#if defined(CURSED_TREES_CELL_MEMORY_PMR)
+			"pmr";
+#elif defined(CURSED_TREES_CELL_MEMORY_ARENA)
+			"arena";
+#else
+			"pool";
+#endif
+
+		/* whether lists of a world share memory, so reservedBytes() is known */
+		static constexpr bool shared =
+#ifdef CURSED_TREES_CELL_MEMORY_SHARED
+			true;
+#else
+			false;
+#endif
+
+	private:
+#ifdef CURSED_TREES_CELL_MEMORY_SHARED
+		CountingResource upstream;
+#endif
+#if defined(CURSED_TREES_CELL_MEMORY_PMR)
+		std::pmr::unsynchronized_pool_resource pool{&upstream};
+#elif defined(CURSED_TREES_CELL_MEMORY_ARENA)
+		std::pmr::monotonic_buffer_resource arena{&upstream};
+		NodeCounter counter{&arena};
+		List spare{&counter};
+#endif
+	};
+}
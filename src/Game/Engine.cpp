@@ -0,0 +1,143 @@
+#include "Engine.hpp"
+#include "Locality.hpp"
+
+#include <random>
+#include <stdexcept>
+
+namespace game
+{
+	std::uint64_t Engine::hash() const
+	{
+		/* FNV-1a over tiles */
+		std::uint64_t hash = 14695981039346656037ull;
+		auto mix = [&](std::uint64_t value) {
+			for (int i = 0; i < 8; i++)
+			{
+				hash ^= (value >> (i * 8)) & 0xFF;
+				hash *= 1099511628211ull;
+			}
+		};
+		for (unsigned int y = 0; y < height(); y++)
+			for (unsigned int x = 0; x < width(); x++)
+			{
+				Tile t = tile({x, y});
+				mix(static_cast<std::uint64_t>(t.kind) | (std::uint64_t(t.activeGene) << 8));
+				mix(static_cast<std::uint32_t>(t.energy) | (std::uint64_t(static_cast<std::uint32_t>(t.age)) << 32));
+			}
+		return hash;
+	}
+
+	/* @a params with the seed picked when it's 0, like World does */
+	static Parameters seeded(Parameters params)
+	{
+		validate_parameters(params);
+		if (params.seed == 0)
+			params.seed = std::random_device{}();
+		return params;
+	}
+
+	ReferenceEngine::ReferenceEngine(unsigned int w, unsigned int h, const Parameters& params)
+		: world(registry, w, h, seeded(params))
+	{
+
+	}
+
+	void ReferenceEngine::spawn(unsigned int x)
+	{
+		reference::Tree::spawn(world, x);
+	}
+
+	bool ReferenceEngine::tick()
+	{
+		bool alive = world.tick(world.params.minSun, world.params.sunLevels);
+		sort_trees<reference::Tree>(registry, year++);
+		return alive;
+	}
+
+	Tile ReferenceEngine::tile(Vector2 pos) const
+	{
+		Tile tile;
+		auto entity = world.at(pos);
+		auto pCell = registry.try_get<Cell>(entity);
+		if (!pCell)
+			return tile;
+		const auto& tree = registry.get<reference::Tree>(pCell->parent);
+		if (registry.all_of<Falling>(pCell->parent))
+			tile.kind = Tile::Kind::SEED;
+		else
+		{
+			tile.kind = pCell->type == Cell::Type::ACTIVE ? Tile::Kind::ACTIVE : Tile::Kind::DEAD;
+			tile.age = registry.get<Living>(pCell->parent).age;
+		}
+		tile.activeGene = pCell->activeGene;
+		tile.energy = tree.energy;
+		return tile;
+	}
+
+	WorldEngine::WorldEngine(unsigned int w, unsigned int h, const Parameters& params)
+		: world(registry, w, h, params)
+	{
+
+	}
+
+	void WorldEngine::spawn(unsigned int x)
+	{
+		Tree::spawn(world, x);
+	}
+
+	bool WorldEngine::tick()
+	{
+		return world.tick();
+	}
+
+	Tile WorldEngine::tile(Vector2 pos) const
+	{
+		Tile tile;
+		auto entity = world.at(pos);
+		auto pCell = registry.try_get<Cell>(entity);
+		if (!pCell)
+			return tile;
+		const auto& tree = registry.get<Tree>(pCell->parent);
+		if (registry.all_of<Falling>(pCell->parent))
+			tile.kind = Tile::Kind::SEED;
+		else
+		{
+			tile.kind = pCell->type == Cell::Type::ACTIVE ? Tile::Kind::ACTIVE : Tile::Kind::DEAD;
+			tile.age = registry.get<Living>(pCell->parent).age;
+		}
+		tile.activeGene = pCell->activeGene;
+		tile.energy = tree.energy;
+		return tile;
+	}
+
+	/* every engine has to be listed here */
+	static const struct
+	{
+		const char* name;
+		std::unique_ptr<Engine> (*create)(unsigned int w, unsigned int h, const Parameters& params);
+	} engines[] = {
+		{"reference", [](unsigned int w, unsigned int h, const Parameters& params) -> std::unique_ptr<Engine> {
+			return std::make_unique<ReferenceEngine>(w, h, params);
+		}},
+		{"optimized", [](unsigned int w, unsigned int h, const Parameters& params) -> std::unique_ptr<Engine> {
+			return std::make_unique<WorldEngine>(w, h, params);
+		}},
+	};
+
+	std::vector<std::string> engine_names()
+	{
+		std::vector<std::string> names;
+		for (auto& engine : engines)
+			names.emplace_back(engine.name);
+		return names;
+	}
+
+	std::unique_ptr<Engine> make_engine(const std::string& name, unsigned int w, unsigned int h,
+										const Parameters& params)
+	{
+		for (auto& engine : engines)
+			if (name == engine.name)
+				return engine.create(w, h, params);
+		throw std::invalid_argument("Unknown engine: " + name);
+	}
+}
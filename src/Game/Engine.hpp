@@ -0,0 +1,118 @@
+#pragma once
+
+#include "World.hpp"
+#include "Reference/World.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <entt/entity/registry.hpp>
+
+namespace game
+{
+	/**
+	 * @brief State of one tile which doesn't depend on how an engine stores it.
+	 */
+	struct Tile
+	{
+		enum class Kind : byte
+		{
+			EMPTY, ACTIVE, DEAD, SEED
+		};
+
+		Kind kind = Kind::EMPTY;
+		byte activeGene = 0;
+		/* energy and age of the tree tile belongs to */
+		int energy = 0;
+		int age = 0;
+
+		bool operator==(const Tile&) const = default;
+	};
+
+	/**
+	 * @brief Common interface of simulation implementations.
+	 * @detail Engines started with the same size and parameters must produce
+	 * identical tiles every tick, ReferenceEngine defines the result.
+	 */
+	class Engine
+	{
+	public:
+		virtual ~Engine() = default;
+
+		virtual const char* name() const = 0;
+		virtual unsigned int width() const = 0;
+		virtual unsigned int height() const = 0;
+
+		/* spawn a tree at the bottom of world, see Tree::spawn */
+		virtual void spawn(unsigned int x) = 0;
+		/* advance by one year, false when there are no trees left */
+		virtual bool tick() = 0;
+		virtual Tile tile(Vector2 pos) const = 0;
+
+		/**
+		 * @brief Hash of all tiles, equal for engines in equal states.
+		 */
+		std::uint64_t hash() const;
+	};
+
+	/**
+	 * @brief Game logic as it was before any optimization, see reference::World.
+	 * @detail Defines the result every other engine is checked against, so
+	 * reference::World and reference::Tree must never be optimized or changed
+	 * together with World. Trees are visited in storage order and it decides
+	 * which tree takes a contested tile, so the engine keeps storage in the
+	 * order World keeps its own, see sort_trees().
+	 */
+	class ReferenceEngine : public Engine
+	{
+	private:
+		entt::registry registry;
+		reference::World world;
+		unsigned int year = 0;
+
+	public:
+		ReferenceEngine(unsigned int w, unsigned int h, const Parameters& params);
+
+		const char* name() const override { return "reference"; }
+		unsigned int width() const override { return world.w; }
+		unsigned int height() const override { return world.h; }
+
+		void spawn(unsigned int x) override;
+		bool tick() override;
+		Tile tile(Vector2 pos) const override;
+	};
+
+	/**
+	 * @brief The ECS implementation the game runs: World and its registry.
+	 */
+	class WorldEngine : public Engine
+	{
+	private:
+		entt::registry registry;
+		World world;
+
+	public:
+		WorldEngine(unsigned int w, unsigned int h, const Parameters& params);
+
+		const char* name() const override { return "optimized"; }
+		unsigned int width() const override { return world.w; }
+		unsigned int height() const override { return world.h; }
+
+		void spawn(unsigned int x) override;
+		bool tick() override;
+		Tile tile(Vector2 pos) const override;
+	};
+
+	/**
+	 * @brief Names of engines make_engine() knows.
+	 */
+	std::vector<std::string> engine_names();
+
+	/**
+	 * @brief Create engine by its name.
+	 * @throw std::invalid_argument if there is no such engine.
+	 */
+	std::unique_ptr<Engine> make_engine(const std::string& name, unsigned int w, unsigned int h,
+										const Parameters& params);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace game
+{
+	/**
+	 * @brief Something which happened to a tree, see World::emit().
+	 */
+	struct TreeEvent
+	{
+		enum class Type : std::uint8_t
+		{
+			/* tree spawned or budded, value is its energy */
+			SPAWN,
+			/* falling seed reached the ground */
+			PLANT,
+			/* value cells grew this tick */
+			GROW,
+			/* tree got old, value is number of seeds it turned into */
+			KILL,
+			/* tree ran out of energy, value is its energy */
+			DESTROY,
+			/* falling seed landed on a cell */
+			SEED_DESTROYED,
+			/* seed's genom mutated, value is index of the gene */
+			MUTATION,
+			/* written by consumers in place of value events which were dropped */
+			DROPPED
+		};
+
+		Type type;
+		std::uint16_t x, y;
+		std::uint32_t year;
+		/* entity of the tree */
+		std::uint32_t tree;
+		std::int32_t value;
+	};
+	static_assert(std::is_trivially_copyable_v<TreeEvent>);
+
+	/**
+	 * @brief Lock free single producer single consumer ring of tree events.
+	 * @detail Producer is the thread which ticks the world, it never blocks:
+	 * when the ring is full the event is dropped and counted. Consumer drains
+	 * events in batches from any other thread.
+	 */
+	class EventStream
+	{
+	public:
+		/* @param capacity rounded up to a power of two */
+		explicit EventStream(std::size_t capacity = 1 << 16)
+			: mask(round(capacity) - 1), events(new TreeEvent[mask + 1])
+		{
+		}
+
+		EventStream(const EventStream&) = delete;
+		EventStream& operator=(const EventStream&) = delete;
+
+		/* producer only, false if event was dropped */
+		bool push(const TreeEvent& event) noexcept
+		{
+			const auto position = head.load(std::memory_order_relaxed);
+			if (position - cachedTail > mask)
+			{
+				cachedTail = tail.load(std::memory_order_acquire);
+				if (position - cachedTail > mask)
+				{
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+			}
+			events[position & mask] = event;
+			head.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * @brief Consumer only, call @a f with every event pushed so far, oldest first.
+		 * @return number of events passed to @a f.
+		 */
+		template<typename F>
+		std::size_t drain(F&& f)
+		{
+			const auto position = tail.load(std::memory_order_relaxed);
+			const auto last = head.load(std::memory_order_acquire);
+			for (auto i = position; i != last; i++)
+				f(events[i & mask]);
+			tail.store(last, std::memory_order_release);
+			return static_cast<std::size_t>(last - position);
+		}
+
+		std::size_t capacity() const noexcept { return mask + 1; }
+		/* number of events dropped because consumer fell behind */
+		std::uint64_t droppedEvents() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+	private:
+		static std::size_t round(std::size_t capacity)
+		{
+			std::size_t size = 1;
+			while (size < capacity)
+				size <<= 1;
+			return size;
+		}
+
+		const std::size_t mask;
+		std::unique_ptr<TreeEvent[]> events;
+		/* written by producer */
+		alignas(64) std::atomic<std::uint64_t> head = 0;
+		std::uint64_t cachedTail = 0;
+		std::atomic<std::uint64_t> dropped = 0;
+		/* written by consumer */
+		alignas(64) std::atomic<std::uint64_t> tail = 0;
+	};
+}
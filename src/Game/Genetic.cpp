@@ -3,12 +3,9 @@
 
 #include <functional>
 #include <entt/entity/handle.hpp>
-#include <effolkronium/random.hpp>
 
 namespace game
 {
-	using Random = effolkronium::random_static;
-
 	bool Gene::grows(const World& world, entt::entity entity, Direction dir, const Vector2& pos) const
 	{
 		auto& reg = world.registry;
@@ -18,9 +15,9 @@ namespace game
 		switch(protein.predicate)
 		{
 			case Gene::Predicate::ENERGY_LESS:
-				return tree.energy <= protein.parameter * 50;
+				return tree.energy <= protein.parameter * world.params.energyScale;
 			case Gene::Predicate::ENERGY_GREATER:
-				return tree.energy >= protein.parameter * 50;
+				return tree.energy >= protein.parameter * world.params.energyScale;
 			case Gene::Predicate::HEIGHT_LESS:
 				return pos.y <= protein.parameter; 
 			case Gene::Predicate::HEIGHT_GREATER:
@@ -34,48 +31,64 @@ namespace game
 		}
 	}
 
-	Gene Gene::random()
+	Gene Gene::random(Random& random)
 	{
 		Gene gene;
-		return random(gene);
+		return Gene::random(random, gene);
 	}
 
-	Gene Gene::random(Gene gene)
+	Gene Gene::random(Random& random, Gene gene)
 	{
 		for (auto& protein : gene.proteins)
-			if (Random::get<bool>(0.4f))
+			if (random.get<bool>(0.4f))
 			{
-				protein.predicate = Random::get({
+				protein.predicate = random.get({
 						Predicate::NONE, Predicate::NONE, Predicate::NONE,
 						Predicate::ENERGY_LESS, Predicate::ENERGY_GREATER, 
 						Predicate::HEIGHT_LESS, Predicate::HEIGHT_GREATER,
 						Predicate::AGE_LESS, Predicate::AGE_GREATER
 					});
-				protein.parameter = Random::get(0, 30);
-				protein.nextGene = Random::get(0, (Genom::num_genes - 1) << 1);
+				protein.parameter = random.get(0, 30);
+				protein.nextGene = random.get(0, (Genom::num_genes - 1) << 1);
 			}
 		return gene;
 	}
 
-	Genom::Genom()
+	Genom::Genom(Random& random)
 	{
 		for (byte i = 0; i < num_genes; i++)
-			genes[i] = Gene::random();
+			genes[i] = Gene::random(random);
 	}
 
-	Genom Genom::clone() const
+	Genom Genom::clone(Random& random, float mutation_chance, byte* mutated) const
 	{
 		Genom copy{*this};
+		if (mutated)
+			*mutated = num_genes;
 		/* Mutation! */
-		if (Random::get<bool>(mutation_chance))
+		if (random.get<bool>(mutation_chance))
 		{
-			auto it = Random::get(copy.genes);
-			*it = Gene::random(*it);
+			auto it = random.get(copy.genes);
+			*it = Gene::random(random, *it);
+			if (mutated)
+				*mutated = static_cast<byte>(it - copy.genes.begin());
 		}
 		return copy;
 	}
 
-	float Genom::mutation_chance = 0.25f;
+	std::uint64_t Genom::hash() const noexcept
+	{
+		/* FNV-1a over proteins */
+		std::uint64_t hash = 14695981039346656037ull;
+		for (auto& gene : genes)
+			for (auto& protein : gene.proteins)
+				for (byte b : {static_cast<byte>(protein.predicate), protein.parameter, protein.nextGene})
+				{
+					hash ^= b;
+					hash *= 1099511628211ull;
+				}
+		return hash;
+	}
 
 	bool Genom::grows(World& world, const Cell& cell, Direction dir, const Vector2& pos) const
 	{
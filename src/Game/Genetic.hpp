@@ -3,11 +3,15 @@
 #include "Components.hpp"
 
 #include <array>
+#include <cstdint>
+#include <effolkronium/random.hpp>
 
 namespace game
 {
 	class World;
 
+	using Random = effolkronium::random_local;
+
 	struct Gene
 	{
 		enum class Predicate : byte
@@ -44,26 +48,35 @@ namespace game
 		bool grows(const World& world, entt::entity tree, Direction dir, const Vector2& pos) const;
 
 		/* generate a random gene */
-		static Gene random();
+		static Gene random(Random& random);
 		/* generate a random gene by mutating an existing one */
-		static Gene random(Gene gene);
+		static Gene random(Random& random, Gene gene);
 	};
 
 	class Genom
 	{
 	public:
 		static constexpr byte num_genes = 16;
-		static float mutation_chance;
 
 	private:
 		std::array<Gene, num_genes> genes;
 
 	public:
-		Genom();
-
-		Genom clone() const;
+		/* genom whose genes don't grow anything */
+		Genom() = default;
+		/* generate a random genom */
+		explicit Genom(Random& random);
+		explicit Genom(const std::array<Gene, num_genes>& genes) : genes(genes) {}
+
+		/**
+		 * @brief Copy genom, a random gene mutates with probability @a mutation_chance.
+		 * @param mutated set to index of the mutated gene or num_genes if none
+		 */
+		Genom clone(Random& random, float mutation_chance, byte* mutated = nullptr) const;
 
 		auto& getGenes() const noexcept { return genes; }
+		/* equal genoms have equal hashes */
+		std::uint64_t hash() const noexcept;
 
 		[[nodiscard]] 
 		bool grows(World& world, const Cell& cell, Direction dir, const Vector2& pos) const;
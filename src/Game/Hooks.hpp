@@ -0,0 +1,41 @@
+#pragma once
+
+#include <span>
+
+namespace game
+{
+	class World;
+
+	/**
+	 * @brief Tree a spawn hook asks for at the bottom of column x.
+	 */
+	struct SpawnRequest
+	{
+		unsigned int x;
+		int energy = 300;
+	};
+
+	/**
+	 * @brief Custom behaviour of a world, see World::hooks.
+	 * @detail Each hook is called at most once per tick from the thread
+	 * simulating the world and gets the whole world, never a single tree or
+	 * cell, so implementations work on arrays and their call overhead doesn't
+	 * grow with the world. Hooks which aren't overridden do nothing.
+	 */
+	class Hooks
+	{
+	public:
+		virtual ~Hooks() = default;
+
+		/* trees to spawn before physics, requests for tiles which are taken are skipped */
+		virtual std::span<const SpawnRequest> spawn(const World&) { return {}; }
+		/**
+		 * @brief Sun of every column, called before sun phase.
+		 * @return World::w values which replace Parameters::minSun in their
+		 * columns, anything else keeps Parameters::minSun everywhere
+		 */
+		virtual std::span<const int> sun(const World&) { return {}; }
+		/* after a tick, World::history already has its statistics */
+		virtual void tickEnd(const World&) {}
+	};
+}
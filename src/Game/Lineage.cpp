@@ -0,0 +1,273 @@
+#include "Lineage.hpp"
+#include "World.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace game
+{
+	constexpr char magic[4] = {'C', 'T', 'L', 'G'};
+	constexpr std::uint32_t version = 1;
+	/* buffered records are written in chunks of this size */
+	constexpr std::size_t chunk_size = 1 << 16;
+
+	enum class Record : byte
+	{
+		TICK, FOUNDER, SEED, PLANT, DEATH
+	};
+
+	static byte tag(Record type, unsigned int high = 0)
+	{
+		return static_cast<byte>(static_cast<unsigned>(type) | (high << 3));
+	}
+
+	Lineage::Lineage(const std::string& filename, const World& world)
+		: file(std::fopen(filename.c_str(), "wb")), filename(filename)
+	{
+		if (!file)
+			throw std::runtime_error("Can't open " + filename);
+		buffer.reserve(chunk_size + 256);
+		for (char c : magic)
+			put(static_cast<byte>(c));
+		for (std::uint32_t value : {version, world.w, world.h, world.params.seed})
+			for (int i = 0; i < 4; i++)
+				put(static_cast<byte>(value >> (i * 8)));
+	}
+
+	Lineage::~Lineage()
+	{
+		try
+		{
+			flush();
+		}
+		catch (const std::runtime_error&)
+		{
+			/* nothing to do about it here */
+		}
+		std::fclose(file);
+	}
+
+	std::uint64_t Lineage::founder(unsigned int year, const Genom& genom)
+	{
+		at(year);
+		put(tag(Record::FOUNDER));
+		for (auto& gene : genom.getGenes())
+			putGene(gene);
+		return next++;
+	}
+
+	std::uint64_t Lineage::seed(unsigned int year, std::uint64_t parent, byte mutatedGene, const Genom& genom)
+	{
+		at(year);
+		const bool mutated = mutatedGene < Genom::num_genes;
+		put(tag(Record::SEED, mutated ? mutatedGene + 1 : 0));
+		putVarint(next - parent);
+		if (mutated)
+			putGene(genom.getGenes()[mutatedGene]);
+		return next++;
+	}
+
+	void Lineage::plant(unsigned int year, std::uint64_t id)
+	{
+		at(year);
+		put(tag(Record::PLANT));
+		putVarint(next - id);
+	}
+
+	void Lineage::died(unsigned int year, std::uint64_t id, Death cause)
+	{
+		at(year);
+		put(tag(Record::DEATH, static_cast<unsigned>(cause)));
+		putVarint(next - id);
+	}
+
+	void Lineage::flush()
+	{
+		if (buffer.empty())
+			return;
+		const std::size_t size = buffer.size();
+		const bool ok = std::fwrite(buffer.data(), 1, size, file) == size && std::fflush(file) == 0;
+		buffer.clear();
+		if (!ok)
+			throw std::runtime_error("Can't write lineage to " + filename);
+		written += size;
+	}
+
+	void Lineage::at(unsigned int year)
+	{
+		if (buffer.size() >= chunk_size)
+			flush();
+		if (year != this->year)
+		{
+			put(tag(Record::TICK));
+			putVarint(year - this->year);
+			this->year = year;
+		}
+	}
+
+	void Lineage::putVarint(std::uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			put(static_cast<byte>(value | 0x80));
+			value >>= 7;
+		}
+		put(static_cast<byte>(value));
+	}
+
+	void Lineage::putGene(const Gene& gene)
+	{
+		for (auto& protein : gene.proteins)
+		{
+			put(static_cast<byte>(protein.predicate));
+			put(protein.parameter);
+			put(protein.nextGene);
+		}
+	}
+
+	LineageReader::LineageReader(const std::string& filename)
+		: file(std::fopen(filename.c_str(), "rb"))
+	{
+		if (!file)
+			throw std::runtime_error("Can't open " + filename);
+		try
+		{
+			char header[4];
+			if (std::fread(header, 1, 4, file) != 4 || std::memcmp(header, magic, 4) != 0)
+				throw std::runtime_error(filename + " is not a lineage log");
+			std::uint32_t values[4];
+			for (auto& value : values)
+			{
+				value = 0;
+				for (int i = 0; i < 4; i++)
+					value |= std::uint32_t(get()) << (i * 8);
+			}
+			if (values[0] != version)
+				throw std::runtime_error(filename + " was written by another version");
+			w = values[1];
+			h = values[2];
+			seed = values[3];
+		}
+		catch (...)
+		{
+			std::fclose(file);
+			throw;
+		}
+	}
+
+	LineageReader::~LineageReader()
+	{
+		std::fclose(file);
+	}
+
+	bool LineageReader::next(LineageEvent& event)
+	{
+		int first;
+		while ((first = std::fgetc(file)) == static_cast<int>(Record::TICK))
+			year += static_cast<unsigned int>(getVarint());
+		if (first == EOF)
+			return false;
+		const unsigned type = first & 7, high = static_cast<unsigned>(first) >> 3;
+		event.year = year;
+		event.parent = 0;
+		event.mutatedGene = Genom::num_genes;
+		switch (static_cast<Record>(type))
+		{
+		case Record::FOUNDER:
+		{
+			std::array<Gene, Genom::num_genes> genes;
+			for (auto& gene : genes)
+				gene = getGene();
+			event.type = LineageEvent::Type::FOUNDER;
+			event.id = ++ids;
+			event.genom = Genom{genes};
+			genoms.emplace(event.id, event.genom);
+			return true;
+		}
+		case Record::SEED:
+		{
+			event.type = LineageEvent::Type::SEED;
+			event.parent = ++ids - getVarint();
+			event.id = ids;
+			auto it = genoms.find(event.parent);
+			if (it == genoms.end())
+				throw std::runtime_error("Lineage log is corrupted: seed of unknown tree");
+			if (high > Genom::num_genes)
+				throw std::runtime_error("Lineage log is corrupted: no such gene");
+			auto genes = it->second.getGenes();
+			if (high)
+			{
+				event.mutatedGene = static_cast<byte>(high - 1);
+				genes[event.mutatedGene] = getGene();
+			}
+			event.genom = Genom{genes};
+			genoms.emplace(event.id, event.genom);
+			return true;
+		}
+		case Record::PLANT:
+		case Record::DEATH:
+		{
+			event.type = type == static_cast<unsigned>(Record::PLANT) ? LineageEvent::Type::PLANT : LineageEvent::Type::DEATH;
+			event.id = getId();
+			auto it = genoms.find(event.id);
+			if (it == genoms.end())
+				throw std::runtime_error("Lineage log is corrupted: unknown tree");
+			event.genom = it->second;
+			if (event.type == LineageEvent::Type::DEATH)
+			{
+				if (high > static_cast<unsigned>(Lineage::Death::OLD))
+					throw std::runtime_error("Lineage log is corrupted: no such death");
+				event.cause = static_cast<Lineage::Death>(high);
+				genoms.erase(it);
+			}
+			return true;
+		}
+		default:
+			throw std::runtime_error("Lineage log is corrupted: unknown record");
+		}
+	}
+
+	byte LineageReader::get()
+	{
+		int value = std::fgetc(file);
+		if (value == EOF)
+			throw std::runtime_error("Lineage log is truncated");
+		return static_cast<byte>(value);
+	}
+
+	std::uint64_t LineageReader::getVarint()
+	{
+		std::uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			byte b = get();
+			value |= std::uint64_t(b & 0x7F) << shift;
+			if (!(b & 0x80))
+				return value;
+		}
+		throw std::runtime_error("Lineage log is corrupted: varint is too long");
+	}
+
+	Gene LineageReader::getGene()
+	{
+		Gene gene;
+		for (auto& protein : gene.proteins)
+		{
+			byte predicate = get();
+			if (predicate >= static_cast<byte>(Gene::Predicate::MAX))
+				throw std::runtime_error("Lineage log is corrupted: no such predicate");
+			protein.predicate = static_cast<Gene::Predicate>(predicate);
+			protein.parameter = get();
+			protein.nextGene = get();
+		}
+		return gene;
+	}
+
+	std::uint64_t LineageReader::getId()
+	{
+		std::uint64_t distance = getVarint();
+		if (distance == 0 || distance > ids)
+			throw std::runtime_error("Lineage log is corrupted: no such tree");
+		return ids + 1 - distance;
+	}
+}
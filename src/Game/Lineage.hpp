@@ -0,0 +1,156 @@
+#pragma once
+
+#include "Genetic.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace game
+{
+	class World;
+
+	/**
+	 * @brief Append only log of every tree's birth, planting and death which
+	 * family tree and history of species can be rebuilt from.
+	 * @detail Trees get sequential ids starting from 1. Only founders (spawned
+	 * trees) store their whole genom, a seed stores its parent and the gene
+	 * which mutated, if any. Format, little endian: "CTLG", u32 version,
+	 * u32 w, u32 h, u32 seed, then records. A record starts with a tag byte,
+	 * type in the low 3 bits:
+	 *   + TICK: varint number of years since the previous TICK
+	 *   + FOUNDER: 16 genes of 4 proteins (predicate, parameter, next gene)
+	 *   + SEED: mutated gene + 1 in high bits (0 if none), varint id - parent,
+	 *     4 proteins of the mutated gene
+	 *   + PLANT: varint ids given so far - id
+	 *   + DEATH: Death in high bits, varint ids given so far - id
+	 * Records are buffered and written in chunks, a tree takes about 10 bytes
+	 * from birth to death, so the log may stay on for millions of births.
+	 * Not thread safe, only one world may write to a log.
+	 */
+	class Lineage
+	{
+	public:
+		enum class Death : byte
+		{
+			/* seed fell on a cell */
+			SEED,
+			/* tree ran out of energy or all of its growth budded off to other stripes */
+			DESTROYED,
+			/* tree got old and turned into seeds */
+			OLD
+		};
+
+		/**
+		 * @throw std::runtime_error if @a filename can't be opened.
+		 */
+		Lineage(const std::string& filename, const World& world);
+		/* writes what is buffered */
+		~Lineage();
+
+		Lineage(const Lineage&) = delete;
+		Lineage& operator=(const Lineage&) = delete;
+
+		/* tree spawned with a random genom, already planted, returns its id */
+		std::uint64_t founder(unsigned int year, const Genom& genom);
+		/**
+		 * @brief Seed of tree @a parent, returns its id.
+		 * @param mutatedGene index of the gene which differs from parent's
+		 * genom or Genom::num_genes, see Genom::clone
+		 */
+		std::uint64_t seed(unsigned int year, std::uint64_t parent, byte mutatedGene, const Genom& genom);
+		void plant(unsigned int year, std::uint64_t id);
+		void died(unsigned int year, std::uint64_t id, Death cause);
+
+		/**
+		 * @brief Write buffered records to file.
+		 * @throw std::runtime_error if writing fails.
+		 */
+		void flush();
+
+		/* number of trees born so far */
+		std::uint64_t births() const noexcept { return next - 1; }
+		/* size of the log including buffered records */
+		std::size_t bytes() const noexcept { return written + buffer.size(); }
+
+	private:
+		void at(unsigned int year);
+		void put(byte value) { buffer.push_back(value); }
+		void putVarint(std::uint64_t value);
+		void putGene(const Gene& gene);
+
+		std::FILE* file;
+		std::string filename;
+		std::vector<byte> buffer;
+		std::size_t written = 0;
+		std::uint64_t next = 1;
+		unsigned int year = 0;
+	};
+
+	/**
+	 * @brief Record of a lineage log with ids resolved and genoms rebuilt.
+	 */
+	struct LineageEvent
+	{
+		enum class Type : byte
+		{
+			FOUNDER, SEED, PLANT, DEATH
+		};
+
+		Type type = Type::FOUNDER;
+		unsigned int year = 0;
+		std::uint64_t id = 0;
+		/* 0 for founders */
+		std::uint64_t parent = 0;
+		/* Genom::num_genes if seed didn't mutate */
+		byte mutatedGene = Genom::num_genes;
+		/* DEATH only */
+		Lineage::Death cause = Lineage::Death::SEED;
+		/* genom of the tree */
+		Genom genom;
+	};
+
+	/**
+	 * @brief Reads a log written by Lineage.
+	 * @detail Keeps genoms of trees which haven't died yet only, so memory
+	 * depends on population rather than length of the log.
+	 */
+	class LineageReader
+	{
+	public:
+		unsigned int w = 0, h = 0;
+		unsigned int seed = 0;
+
+		/**
+		 * @throw std::runtime_error if file can't be read or isn't a lineage log.
+		 */
+		explicit LineageReader(const std::string& filename);
+		~LineageReader();
+
+		LineageReader(const LineageReader&) = delete;
+		LineageReader& operator=(const LineageReader&) = delete;
+
+		/**
+		 * @brief Read next record.
+		 * @return false at the end of log.
+		 * @throw std::runtime_error if log is truncated or corrupted.
+		 */
+		bool next(LineageEvent& event);
+		/* genoms of trees and seeds which are alive at the current record */
+		const std::unordered_map<std::uint64_t, Genom>& alive() const noexcept { return genoms; }
+
+	private:
+		byte get();
+		std::uint64_t getVarint();
+		Gene getGene();
+		/* resolve id written as distance from the next one */
+		std::uint64_t getId();
+
+		std::FILE* file;
+		std::unordered_map<std::uint64_t, Genom> genoms;
+		std::uint64_t ids = 0;
+		unsigned int year = 0;
+	};
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Components.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <entt/core/algorithm.hpp>
+#include <entt/entity/registry.hpp>
+
+namespace game
+{
+	/* storage is sorted when more than 1/sort_threshold of trees are out of order */
+	inline constexpr std::size_t sort_threshold = 8;
+	/* or every sort_period years when any are */
+	inline constexpr unsigned int sort_period = 64;
+
+	/* position of the cell @a tree grew from or of the seed itself, x first */
+	template<typename T>
+	std::uint64_t root_key(const T& tree) noexcept
+	{
+		Vector2 pos{};
+		if (!tree.deadCells.empty())
+			pos = tree.deadCells.front();
+		else if (!tree.aliveCells.empty())
+			pos = tree.aliveCells.front();
+		return (std::uint64_t(pos.x) << 32) | pos.y;
+	}
+
+	/**
+	 * @brief Order trees of type @a T, their Living and Falling components in
+	 * storage by positions of their roots, so views visit neighbouring trees
+	 * one after another.
+	 * @detail Storage stays mostly sorted between ticks, only born trees and
+	 * trees moved into places of dead ones are out of order, so it's sorted
+	 * only when more than 1/sort_threshold of trees are out of order or once
+	 * in sort_period years when any are. Uses insertion sort when a few trees
+	 * are out of order and std::sort when a lot of them are.
+	 * Views visit trees in storage order and that order decides which tree
+	 * takes a contested tile, so worlds sorted the same way tick the same way.
+	 * @param year number of ticks simulated
+	 * @return whether storage was sorted
+	 */
+	template<typename T>
+	bool sort_trees(entt::registry& registry, unsigned int year)
+	{
+		std::size_t unordered = 0;
+		std::uint64_t last = 0;
+		for (auto&& [entity, tree] : registry.view<T>().each())
+		{
+			const std::uint64_t key = root_key(tree);
+			unordered += key < last;
+			last = key;
+		}
+		const std::size_t size = registry.size<T>();
+		if (unordered * sort_threshold <= size && (unordered == 0 || year % sort_period != 0))
+			return false;
+		auto compare = [](const T& lhs, const T& rhs) {
+			return root_key(lhs) < root_key(rhs);
+		};
+		/* insertion sort moves every misplaced tree across up to the whole storage,
+		   std::sort costs log(n) per tree */
+		if (unordered < static_cast<std::size_t>(std::bit_width(size)))
+			registry.sort<T>(compare, entt::insertion_sort{});
+		else
+			registry.sort<T>(compare);
+		registry.sort<Living, T>();
+		registry.sort<Falling, T>();
+		return true;
+	}
+}
@@ -0,0 +1,86 @@
+#include "Memory.hpp"
+#include "World.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <entt/entity/registry.hpp>
+
+namespace game
+{
+	/* lida::MemoryPool's default block size, each block starts with a pointer to the next one */
+	constexpr std::size_t pool_block_size = 4096;
+	/* node of std::list: two links and the value */
+	constexpr std::size_t list_node_size = sizeof(Vector2) + 2 * sizeof(void*);
+	constexpr std::size_t nodes_per_block = (pool_block_size - sizeof(void*)) / list_node_size;
+
+	template<typename T>
+	static PoolMemory pool_memory(const entt::registry& registry, const char* name)
+	{
+		PoolMemory pool;
+		pool.name = name;
+		pool.size = registry.size<T>();
+		pool.capacity = registry.capacity<T>();
+		pool.liveBytes = pool.size * (sizeof(T) + sizeof(entt::entity));
+		pool.reservedBytes = pool.capacity * (sizeof(T) + sizeof(entt::entity));
+		return pool;
+	}
+
+	static std::size_t pool_blocks(std::size_t nodes)
+	{
+		return (nodes + nodes_per_block - 1) / nodes_per_block;
+	}
+
+	static void read_rss(MemoryReport& report)
+	{
+		long pageSize = sysconf(_SC_PAGESIZE);
+		std::ifstream statm("/proc/self/statm");
+		std::size_t pages = 0, resident = 0;
+		if (statm >> pages >> resident)
+			report.rss = resident * pageSize;
+		rusage usage{};
+		if (getrusage(RUSAGE_SELF, &usage) == 0)
+			report.peakRss = static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+		/* ru_maxrss is updated lazily */
+		report.peakRss = std::max(report.peakRss, report.rss);
+	}
+
+	std::size_t MemoryReport::total() const
+	{
+		std::size_t bytes = entityBytes + fieldBytes + listPoolBytes;
+		for (auto& pool : pools)
+			bytes += pool.reservedBytes;
+		return bytes;
+	}
+
+	MemoryReport memory_report(const World& world)
+	{
+		auto& reg = world.registry;
+		MemoryReport report;
+		report.pools.push_back(pool_memory<Cell>(reg, "cell"));
+		report.pools.push_back(pool_memory<Tree>(reg, "tree"));
+		report.pools.push_back(pool_memory<Living>(reg, "living"));
+		report.pools.push_back(pool_memory<Falling>(reg, "falling"));
+		report.entities = reg.alive();
+		report.entityCapacity = reg.capacity();
+		report.entityBytes = report.entityCapacity * sizeof(entt::entity);
+		report.fieldBytes = std::size_t(world.w) * world.h * sizeof(entt::entity);
+		for (auto&& [entity, tree] : reg.view<Tree>().each())
+		{
+			for (auto* list : {&tree.aliveCells, &tree.deadCells})
+			{
+				report.lists++;
+				report.listNodes += list->size();
+				if constexpr (!CellMemory::shared)
+					report.listPoolBytes += pool_blocks(list->size()) * pool_block_size;
+			}
+		}
+		report.listNodeBytes = report.listNodes * list_node_size;
+		if constexpr (CellMemory::shared)
+			report.listPoolBytes = world.cellMemory->reservedBytes();
+		report.genomBytes = reg.size<Tree>() * sizeof(Genom);
+		read_rss(report);
+		return report;
+	}
+}
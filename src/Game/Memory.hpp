@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace game
+{
+	class World;
+
+	/**
+	 * @brief Memory taken by a component pool of registry.
+	 * @detail Counts components and their packed entity array, sparse
+	 * index pages of the pool are not included.
+	 */
+	struct PoolMemory
+	{
+		const char* name = "";
+		std::size_t size = 0;
+		std::size_t capacity = 0;
+		std::size_t liveBytes = 0;
+		std::size_t reservedBytes = 0;
+	};
+
+	/**
+	 * @brief Where memory of a world goes.
+	 */
+	struct MemoryReport
+	{
+		std::vector<PoolMemory> pools;
+		/* entities of registry: one per tile plus one per tree */
+		std::size_t entities = 0;
+		std::size_t entityCapacity = 0;
+		std::size_t entityBytes = 0;
+		/* world's tile -> entity table */
+		std::size_t fieldBytes = 0;
+		/* nodes of trees' aliveCells and deadCells lists */
+		std::size_t listNodes = 0;
+		std::size_t listNodeBytes = 0;
+		/* memory lists take from the system, see CellMemory. When every list
+		 * owns its own pool it's estimated from list sizes because nodes freed
+		 * to a pool aren't visible */
+		std::size_t listPoolBytes = 0;
+		std::size_t lists = 0;
+		/* genomes live inside Tree components, this is a part of Tree pool */
+		std::size_t genomBytes = 0;
+		/* resident set size of the whole process, current and peak since start */
+		std::size_t rss = 0;
+		std::size_t peakRss = 0;
+
+		/**
+		 * @brief Bytes reserved by everything above except process' RSS.
+		 */
+		std::size_t total() const;
+	};
+
+	/**
+	 * @brief Measure memory used by @a world and its registry.
+	 */
+	MemoryReport memory_report(const World& world);
+}
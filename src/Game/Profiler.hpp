@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+
+namespace game
+{
+	/**
+	 * @brief Timings and counters of one World::tick.
+	 * @detail Filled only when the game is built with CURSED_TREES_PROFILE
+	 * defined, otherwise it stays zeroed and costs nothing.
+	 */
+	struct TickProfile
+	{
+		enum Phase
+		{
+			PHYSICS,
+			GROW,
+			SUN,
+			NUM_PHASES
+		};
+
+		std::chrono::nanoseconds time[NUM_PHASES]{};
+		/* falling seeds for physics, living trees for growth, cells for sun */
+		unsigned int entities[NUM_PHASES]{};
+		unsigned int cellsGrown = 0;
+		unsigned int seedsSpawned = 0;
+		/* seeds which fell on a cell */
+		unsigned int seedsDestroyed = 0;
+		unsigned int seedsPlanted = 0;
+		/* nodes taken from and returned to trees' cell list pools */
+		unsigned int nodesAllocated = 0;
+		unsigned int nodesFreed = 0;
+
+		std::chrono::nanoseconds total() const { return time[PHYSICS] + time[GROW] + time[SUN]; }
+	};
+
+	/**
+	 * @brief Adds time spent in its scope to a phase of tick profile.
+	 */
+	class PhaseTimer
+	{
+	private:
+		using clock = std::chrono::steady_clock;
+
+		std::chrono::nanoseconds& time;
+		clock::time_point start;
+
+	public:
+		PhaseTimer(TickProfile& profile, TickProfile::Phase phase)
+			: time(profile.time[phase]), start(clock::now()) {}
+		~PhaseTimer() { time += clock::now() - start; }
+
+		PhaseTimer(const PhaseTimer&) = delete;
+		PhaseTimer& operator=(const PhaseTimer&) = delete;
+	};
+
+#ifdef CURSED_TREES_PROFILE
+	/* whether TickProfile is filled */
+	constexpr bool profiling_enabled = true;
+
+/* start a new tick profile of world */
+#define CURSED_TREES_PROFILE_RESET(world) ((world).profile = ::game::TickProfile{})
+/* time rest of current scope as a tick phase */
+#define CURSED_TREES_PROFILE_PHASE(world, phase) \
+	::game::PhaseTimer profilePhaseTimer_{(world).profile, ::game::TickProfile::phase}
+/* add n to a counter of world's tick profile */
+#define CURSED_TREES_PROFILE_COUNT(world, counter, n) ((world).profile.counter += (n))
+#else
+	constexpr bool profiling_enabled = false;
+
+#define CURSED_TREES_PROFILE_RESET(world) ((void)0)
+#define CURSED_TREES_PROFILE_PHASE(world, phase) ((void)0)
+#define CURSED_TREES_PROFILE_COUNT(world, counter, n) ((void)0)
+#endif
+}
@@ -0,0 +1,79 @@
+#include "Genetic.hpp"
+#include "World.hpp"
+
+#include <functional>
+#include <entt/entity/handle.hpp>
+
+namespace game::reference
+{
+	bool Gene::grows(const World& world, entt::entity entity, Direction dir, const Vector2& pos) const
+	{
+		auto& reg = world.registry;
+		auto& tree = reg.get<Tree>(entity);
+		auto& living = reg.get<Living>(entity);
+		auto& protein = proteins[static_cast<byte>(dir)];
+		switch(protein.predicate)
+		{
+			case Gene::Predicate::ENERGY_LESS:
+				return tree.energy <= protein.parameter * world.params.energyScale;
+			case Gene::Predicate::ENERGY_GREATER:
+				return tree.energy >= protein.parameter * world.params.energyScale;
+			case Gene::Predicate::HEIGHT_LESS:
+				return pos.y <= protein.parameter; 
+			case Gene::Predicate::HEIGHT_GREATER:
+				return pos.y >= protein.parameter; 
+			case Gene::Predicate::AGE_LESS:
+				return living.age <= protein.parameter; 
+			case Gene::Predicate::AGE_GREATER:
+				return living.age >= protein.parameter; 
+			default:
+				return true;
+		}
+	}
+
+	Gene Gene::random(Random& random)
+	{
+		Gene gene;
+		return Gene::random(random, gene);
+	}
+
+	Gene Gene::random(Random& random, Gene gene)
+	{
+		for (auto& protein : gene.proteins)
+			if (random.get<bool>(0.4f))
+			{
+				protein.predicate = random.get({
+						Predicate::NONE, Predicate::NONE, Predicate::NONE,
+						Predicate::ENERGY_LESS, Predicate::ENERGY_GREATER, 
+						Predicate::HEIGHT_LESS, Predicate::HEIGHT_GREATER,
+						Predicate::AGE_LESS, Predicate::AGE_GREATER
+					});
+				protein.parameter = random.get(0, 30);
+				protein.nextGene = random.get(0, (Genom::num_genes - 1) << 1);
+			}
+		return gene;
+	}
+
+	Genom::Genom(Random& random)
+	{
+		for (byte i = 0; i < num_genes; i++)
+			genes[i] = Gene::random(random);
+	}
+
+	Genom Genom::clone(Random& random, float mutation_chance) const
+	{
+		Genom copy{*this};
+		/* Mutation! */
+		if (random.get<bool>(mutation_chance))
+		{
+			auto it = random.get(copy.genes);
+			*it = Gene::random(random, *it);
+		}
+		return copy;
+	}
+
+	bool Genom::grows(World& world, const Cell& cell, Direction dir, const Vector2& pos) const
+	{
+		return genes[cell.activeGene].grows(world, cell.parent, dir, pos);
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Game/Components.hpp"
+
+#include <array>
+#include <effolkronium/random.hpp>
+
+namespace game::reference
+{
+	class World;
+
+	using Random = effolkronium::random_local;
+
+	struct Gene
+	{
+		enum class Predicate : byte
+		{
+			NONE,
+			ENERGY_LESS,
+			ENERGY_GREATER,
+			HEIGHT_LESS,
+			HEIGHT_GREATER,
+			AGE_LESS,
+			AGE_GREATER,
+			MAX
+		};
+	
+		struct Protein
+		{
+			Predicate predicate = Predicate::NONE;
+			byte parameter = 0;
+			byte nextGene = 30;
+		};
+
+		std::array<Protein, 4> proteins;
+
+		bool grows(const World& world, entt::entity tree, Direction dir, const Vector2& pos) const;
+
+		/* generate a random gene */
+		static Gene random(Random& random);
+		/* generate a random gene by mutating an existing one */
+		static Gene random(Random& random, Gene gene);
+	};
+
+	class Genom
+	{
+	public:
+		static constexpr byte num_genes = 16;
+
+	private:
+		std::array<Gene, num_genes> genes;
+
+	public:
+		explicit Genom(Random& random);
+
+		Genom clone(Random& random, float mutation_chance) const;
+
+		auto& getGenes() const noexcept { return genes; }
+
+		[[nodiscard]] 
+		bool grows(World& world, const Cell& cell, Direction dir, const Vector2& pos) const;
+	};
+}
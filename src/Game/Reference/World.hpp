@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Tree.hpp"
+#include "Game/World.hpp"
+
+#include <entt/entity/fwd.hpp>
+
+namespace game::reference
+{
+	class World
+	{
+	private:
+		entt::entity* field;
+
+	public:
+		entt::registry& registry;
+		const unsigned int w;
+		const unsigned int h;
+		/* seed must be set */
+		const Parameters params;
+		Random random;
+
+		World(entt::registry& registry, unsigned int w, unsigned int h, const Parameters& params);
+		~World() noexcept;
+		World(World&& world) noexcept;
+		World& operator=(World&& world) noexcept;
+
+		entt::entity at(Vector2 pos) const;
+
+		void sun(int min, unsigned int levels);
+		void physics();
+		void growTrees();
+		bool tick(int min, unsigned int levels);
+	};
+}
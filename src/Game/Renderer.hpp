@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Trace.hpp"
 #include "World.hpp"
 
 #include <entt/entity/registry.hpp>
@@ -40,6 +41,7 @@ namespace game
 
 		void render(bool energyMode)
 		{
+			CURSED_TREES_TRACE("Renderer::render");
 			unsigned int w = std::min(unsigned(displayer_type::width()), world.w-x);
 			unsigned int h = std::min(unsigned(displayer_type::height()), world.h-y);
 			auto& reg = world.registry;
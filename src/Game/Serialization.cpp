@@ -1,8 +1,14 @@
 #include "Serialization.hpp"
+#include "Trace.hpp"
 #include "World.hpp"
 
+#include <algorithm>
 #include <entt/entity/handle.hpp>
+#include <fstream>
+#include <iterator>
 #include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string_view>
 
 namespace game
 {
@@ -30,41 +36,47 @@ namespace game
 				 {"active_gene", static_cast<unsigned int>(c.activeGene)}};
 	}
 
+	/* names of predicates in json, indexed by Gene::Predicate */
+	constexpr std::string_view predicate_names[] = {
+		"none", "energy_less", "energy_greater", "height_less", "height_greater", "age_less", "age_greater"
+	};
+	static_assert(std::size(predicate_names) == static_cast<std::size_t>(Gene::Predicate::MAX));
+
 	void to_json(json& j, const Gene::Protein& protein)
 	{
-		std::string_view predicate;
-		switch(protein.predicate)
-		{
-			case Gene::Predicate::NONE:
-				predicate = "none";
-				break;
-			case Gene::Predicate::ENERGY_LESS:
-				predicate = "energy_less";
-				break;
-			case Gene::Predicate::ENERGY_GREATER:
-				predicate = "energy_greater";
-				break;
-			case Gene::Predicate::HEIGHT_LESS:
-				predicate = "height_less";
-				break;
-			case Gene::Predicate::HEIGHT_GREATER:
-				predicate = "height_greater";
-				break;
-			case Gene::Predicate::AGE_GREATER:
-				predicate = "age_greater";
-				break;
-			case Gene::Predicate::AGE_LESS:
-				predicate = "age_less";
-				break;
-			default: 
-				predicate = "undefined";
-				break;
-		}
+		const auto index = static_cast<std::size_t>(protein.predicate);
+		std::string_view predicate = index < std::size(predicate_names) ? predicate_names[index] : "undefined";
 		j = json{{"predicate", predicate},
 				 {"parameter", protein.parameter},
 				 {"nextGene", protein.nextGene}};
 	}
 
+	void from_json(const json& j, Gene::Protein& protein)
+	{
+		const auto predicate = j.at("predicate").get<std::string>();
+		auto it = std::find(std::begin(predicate_names), std::end(predicate_names), predicate);
+		if (it == std::end(predicate_names))
+			throw std::invalid_argument("Unknown predicate " + predicate);
+		protein.predicate = static_cast<Gene::Predicate>(it - std::begin(predicate_names));
+		protein.parameter = j.at("parameter").get<byte>();
+		protein.nextGene = j.at("nextGene").get<byte>();
+	}
+
+	void from_json(const json& j, Gene& gene)
+	{
+		j.at("up").get_to(gene.up());
+		j.at("down").get_to(gene.down());
+		j.at("left").get_to(gene.left());
+		j.at("right").get_to(gene.right());
+	}
+
+	void from_json(const json& j, Genom& genom)
+	{
+		if (!j.is_array() || j.size() != Genom::num_genes)
+			throw std::invalid_argument("Genom must be an array of " + std::to_string(Genom::num_genes) + " genes");
+		genom = Genom{j.get<std::array<Gene, Genom::num_genes>>()};
+	}
+
 	void to_json(json& j, const Gene& gene)
 	{
 		j = json{{"up", gene.up()},
@@ -132,4 +144,39 @@ namespace game
 		}
 		else throw std::runtime_error("Passed undefined entity to serialize");
 	}
+
+	void dump_json(const World& world, const std::string& filename)
+	{
+		CURSED_TREES_TRACE("dump_json");
+		json j;
+		for (int i = 0; entt::entity entity : world.registry.view<Tree>())
+		{
+			j["tree" + std::to_string(i)] = serialize_tree(world, entity);
+			i++;
+		}
+		std::ofstream out(filename);
+		out << j.dump(2);
+	}
+
+	std::vector<Genom> load_genomes(const std::string& filename)
+	{
+		std::ifstream in(filename);
+		if (!in)
+			throw std::runtime_error("Can't open " + filename);
+		std::vector<Genom> genomes;
+		try
+		{
+			const auto j = json::parse(in);
+			/* dump is an object of trees, ranking is an array of scores, both have their genom inside */
+			for (auto& item : j)
+				genomes.push_back((item.is_object() ? item.at("genom") : item).get<Genom>());
+		}
+		catch (const std::exception& e) /* json::exception or std::invalid_argument */
+		{
+			throw std::runtime_error("Can't read genomes from " + filename + ": " + e.what());
+		}
+		if (genomes.empty())
+			throw std::runtime_error("No genomes in " + filename);
+		return genomes;
+	}
 }
@@ -4,6 +4,8 @@
 #include "Tree.hpp"
 
 #include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <vector>
 
 namespace game
 {
@@ -17,7 +19,24 @@ namespace game
 	void to_json(json& j, const Gene& gene);
 	void to_json(json& j, const Genom& genom);
 	void to_json(json& j, const Tree& tree);
+
+	/* @throw std::invalid_argument on unknown predicate, json::exception on malformed json */
+	void from_json(const json& j, Gene::Protein& protein);
+	void from_json(const json& j, Gene& gene);
+	void from_json(const json& j, Genom& genom);
 	
 	json serialize_tree(const World& world, entt::entity tree);
 	json serialize(const entt::handle& object);
+
+	/**
+	 * @brief Write all trees of @a world to file @a filename in json format.
+	 */
+	void dump_json(const World& world, const std::string& filename = "dump.json");
+
+	/**
+	 * @brief Read genomes from a file written by dump_json() or by
+	 * runtime::evaluate_genomes(), or from a json array of genomes.
+	 * @throw std::runtime_error if file can't be read or has no genomes
+	 */
+	std::vector<Genom> load_genomes(const std::string& filename);
 }
@@ -0,0 +1,50 @@
+#include "Statistics.hpp"
+#include "World.hpp"
+
+#include <algorithm>
+#include <entt/entity/registry.hpp>
+
+namespace game
+{
+	Population::Population(int maxAge)
+		: births(std::max(maxAge, 0) + 1)
+	{
+
+	}
+
+	void Population::born(const Genom& genom, unsigned int year)
+	{
+		births[year % births.size()]++;
+		genoms[genom.hash()]++;
+	}
+
+	void Population::died(const Genom& genom, unsigned int year)
+	{
+		births[year % births.size()]--;
+		auto it = genoms.find(genom.hash());
+		if (--it->second == 0)
+			genoms.erase(it);
+	}
+
+	void Population::ages(unsigned int year, std::span<unsigned int> buckets) const
+	{
+		std::fill(buckets.begin(), buckets.end(), 0u);
+		const std::size_t n = births.size();
+		const std::size_t oldest = std::min<std::size_t>(year, n - 1);
+		for (std::size_t age = 0; age <= oldest; age++)
+			buckets[age * buckets.size() / n] += births[(year - age) % n];
+	}
+
+	Statistics gather_statistics(const World& world)
+	{
+		auto& reg = world.registry;
+		Statistics stats;
+		stats.year = world.year;
+		stats.trees = reg.size<Tree>();
+		stats.seeds = reg.size<Falling>();
+		stats.cells = reg.size<Cell>();
+		stats.energy = world.population.energy;
+		stats.species = world.population.species();
+		return stats;
+	}
+}
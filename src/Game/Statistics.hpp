@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Genetic.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace game
+{
+	class World;
+
+	/**
+	 * @brief Population summary of a world.
+	 */
+	struct Statistics
+	{
+		/* number of ticks world had simulated */
+		unsigned int year = 0;
+		/* all trees, including falling seeds */
+		std::size_t trees = 0;
+		std::size_t seeds = 0;
+		std::size_t cells = 0;
+		long long energy = 0;
+		/* distinct genoms among living trees */
+		std::size_t species = 0;
+
+		std::size_t living() const { return trees - seeds; }
+	};
+
+	/**
+	 * @brief Aggregates of a world which can't be read from registry's sizes.
+	 * @detail Everything creating, killing or feeding trees updates them, so
+	 * reading them doesn't scan the registry.
+	 */
+	class Population
+	{
+	public:
+		/* energy of all trees, including falling seeds */
+		long long energy = 0;
+
+		/* trees never get older than @a maxAge */
+		explicit Population(int maxAge = 0);
+
+		/* tree with @a genom started living at @a year */
+		void born(const Genom& genom, unsigned int year);
+		/* living tree with @a genom which was born at @a year died */
+		void died(const Genom& genom, unsigned int year);
+
+		std::size_t species() const { return genoms.size(); }
+		/**
+		 * @brief Count living trees by age at @a year.
+		 * @detail Ages [0, maxAge] are split into @a buckets.size() equal
+		 * ranges. Costs O(maxAge).
+		 */
+		void ages(unsigned int year, std::span<unsigned int> buckets) const;
+
+	private:
+		/* living trees by year they were born in, modulo size */
+		std::vector<unsigned int> births;
+		/* living trees by hash of their genom */
+		std::unordered_map<std::uint64_t, unsigned int> genoms;
+	};
+
+	/**
+	 * @brief Ring buffer which keeps last @a N pushed values.
+	 */
+	template<typename T, std::size_t N>
+	class History
+	{
+	private:
+		std::array<T, N> values{};
+		std::size_t next = 0;
+		std::size_t count = 0;
+
+	public:
+		void push(const T& value) noexcept
+		{
+			values[next] = value;
+			next = (next + 1) % N;
+			if (count < N)
+				count++;
+		}
+
+		std::size_t size() const noexcept { return count; }
+		static constexpr std::size_t capacity() noexcept { return N; }
+		bool empty() const noexcept { return count == 0; }
+
+		/* @a i-th value from the oldest one */
+		const T& operator[](std::size_t i) const noexcept { return values[(next + N - count + i) % N]; }
+		const T& back() const noexcept { return (*this)[count - 1]; }
+	};
+
+	/**
+	 * @brief Summary of @a world from registry's sizes and World::population, O(1).
+	 */
+	Statistics gather_statistics(const World& world);
+}
@@ -0,0 +1,131 @@
+#include "Trace.hpp"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace game::trace
+{
+	std::atomic<bool> enabled = false;
+
+	namespace
+	{
+		/* fields are atomic because write() may read a slot which is being overwritten,
+		 * sequence is odd while the slot is written and 2*(index+1) when span index is in it */
+		struct Span
+		{
+			std::atomic<std::uint64_t> sequence;
+			std::atomic<const char*> name;
+			std::atomic<std::int64_t> start;
+			std::atomic<std::int64_t> end;
+		};
+
+		/* single producer ring buffer, only the owning thread records to it */
+		struct Buffer
+		{
+			int tid = 0;
+			/* guarded by buffersMutex */
+			std::string threadName;
+			/* number of spans ever recorded */
+			std::atomic<std::uint64_t> head = 0;
+			std::unique_ptr<Span[]> spans{new Span[buffer_size]()};
+		};
+
+		const clock::time_point epoch = clock::now();
+
+		std::mutex buffersMutex;
+		/* buffers outlive their threads so spans of finished threads can be written too */
+		std::vector<std::shared_ptr<Buffer>> buffers;
+
+		Buffer& local_buffer()
+		{
+			thread_local std::shared_ptr<Buffer> buffer = [] {
+				auto buffer = std::make_shared<Buffer>();
+				std::lock_guard lock(buffersMutex);
+				buffer->tid = static_cast<int>(buffers.size()) + 1;
+				buffer->threadName = "thread " + std::to_string(buffer->tid);
+				buffers.push_back(buffer);
+				return buffer;
+			}();
+			return *buffer;
+		}
+
+		std::int64_t since_epoch(clock::time_point time)
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(time - epoch).count();
+		}
+	}
+
+	void enable(bool on)
+	{
+		enabled.store(on, std::memory_order_relaxed);
+	}
+
+	void name_thread(const std::string& name)
+	{
+		auto& buffer = local_buffer();
+		std::lock_guard lock(buffersMutex);
+		buffer.threadName = name;
+	}
+
+	void record(const char* name, clock::time_point start, clock::time_point end)
+	{
+		auto& buffer = local_buffer();
+		const auto index = buffer.head.load(std::memory_order_relaxed);
+		auto& span = buffer.spans[index % buffer_size];
+		span.sequence.store(2 * index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		span.name.store(name, std::memory_order_relaxed);
+		span.start.store(since_epoch(start), std::memory_order_relaxed);
+		span.end.store(since_epoch(end), std::memory_order_relaxed);
+		span.sequence.store(2 * index + 2, std::memory_order_release);
+		buffer.head.store(index + 1, std::memory_order_release);
+	}
+
+	std::size_t write(const std::string& filename)
+	{
+		using nlohmann::json;
+		std::vector<std::pair<std::shared_ptr<Buffer>, std::string>> threads;
+		{
+			std::lock_guard lock(buffersMutex);
+			for (auto& buffer : buffers)
+				threads.emplace_back(buffer, buffer->threadName);
+		}
+
+		json events = json::array();
+		std::size_t count = 0;
+		for (auto& [buffer, threadName] : threads)
+		{
+			events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", buffer->tid},
+							  {"args", {{"name", threadName}}}});
+
+			const auto head = buffer->head.load(std::memory_order_acquire);
+			const auto first = head > buffer_size ? head - buffer_size : 0;
+			for (auto i = first; i < head; i++)
+			{
+				auto& span = buffer->spans[i % buffer_size];
+				const auto sequence = span.sequence.load(std::memory_order_acquire);
+				const char* name = span.name.load(std::memory_order_relaxed);
+				const auto start = span.start.load(std::memory_order_relaxed);
+				const auto end = span.end.load(std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				/* skip spans which the owner overwrote while we were reading them */
+				if (sequence != 2 * i + 2 || span.sequence.load(std::memory_order_relaxed) != sequence)
+					continue;
+				events.push_back({{"name", name}, {"cat", "cursed-trees"}, {"ph", "X"},
+								  {"ts", start / 1000.0}, {"dur", (end - start) / 1000.0},
+								  {"pid", 1}, {"tid", buffer->tid}});
+				count++;
+			}
+		}
+
+		std::ofstream out(filename);
+		if (!out)
+			throw std::runtime_error("Can't open " + filename);
+		out << json{{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}}.dump();
+		return count;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace game::trace
+{
+	using clock = std::chrono::steady_clock;
+
+	/* number of latest spans kept for every thread */
+	constexpr std::size_t buffer_size = 1 << 16;
+
+	extern std::atomic<bool> enabled;
+
+	/**
+	 * @brief Start or stop recording spans. Recording is off by default.
+	 */
+	void enable(bool on);
+
+	/**
+	 * @brief Name calling thread in trace viewer.
+	 */
+	void name_thread(const std::string& name);
+
+	/**
+	 * @brief Record a finished span on calling thread.
+	 * @detail @a name must outlive the trace, string literals are expected.
+	 * Every thread writes to its own ring buffer without locking, the oldest
+	 * spans are overwritten when it is full.
+	 */
+	void record(const char* name, clock::time_point start, clock::time_point end);
+
+	/**
+	 * @brief Write spans recorded so far by all threads to @a filename in
+	 * Chrome trace event format, open it in chrome://tracing or Perfetto.
+	 * @detail Can be called while other threads are recording.
+	 * @return number of written spans.
+	 * @throw std::runtime_error if file can't be opened.
+	 */
+	std::size_t write(const std::string& filename);
+
+	/**
+	 * @brief Records a span from construction to destruction.
+	 */
+	class Scope
+	{
+	private:
+		const char* name;
+		clock::time_point start;
+
+	public:
+		explicit Scope(const char* name)
+			: name(enabled.load(std::memory_order_relaxed) ? name : nullptr)
+		{
+			if (this->name) start = clock::now();
+		}
+		~Scope()
+		{
+			if (name) record(name, start, clock::now());
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+}
+
+/* trace rest of current scope as a span named `name` */
+#define CURSED_TREES_TRACE(name) ::game::trace::Scope traceScope_{name}
@@ -4,32 +4,60 @@
 #include <functional>
 #include <entt/entity/handle.hpp>
 #include <entt/entity/registry.hpp>
-#include <effolkronium/random.hpp>
 
 namespace game
 {
-	using Random = effolkronium::random_static;
+	Vector2 Tree::root() const
+	{
+		if (!deadCells.empty())
+			return deadCells.front();
+		return aliveCells.empty() ? Vector2{} : aliveCells.front();
+	}
 
-	Tree::Tree(int energy, const Genom& genom)
-		: energy(energy), genom(genom)
+	Tree::Tree(int energy, const Genom& genom, CellMemory& memory)
+		: energy(energy), aliveCells(memory.list()), deadCells(memory.list()), genom(genom)
 	{
 		
 	}
 
+	Tree::Tree(const Tree& tree, CellMemory& memory)
+		: energy(tree.energy), aliveCells(memory.list()), deadCells(memory.list()), genom(tree.genom)
+		, lineage(tree.lineage)
+	{
+		aliveCells.assign(tree.aliveCells.begin(), tree.aliveCells.end());
+		deadCells.assign(tree.deadCells.begin(), tree.deadCells.end());
+	}
+
 	Tree& Tree::spawn(World& world, unsigned int x, int energy)
+	{
+		return spawn(world, x, energy, Genom{world.random});
+	}
+
+	Tree& Tree::spawn(World& world, unsigned int x, int energy, const Genom& genom)
 	{
 		auto& reg = world.registry;
 		entt::entity entity = reg.create();
-		auto& tree = reg.emplace<Tree>(entity, energy);
-		tree.aliveCells.push_back({x, 0});
+		auto& tree = reg.emplace<Tree>(entity, energy, genom, *world.cellMemory);
+		world.hashTree(entity, energy);
+		world.population.energy += energy;
+		world.population.born(tree.genom, world.year);
+		if (world.lineage)
+			tree.lineage = world.lineage->founder(world.year, tree.genom);
+		world.emit(TreeEvent::Type::SPAWN, {x, 0}, entity, energy);
+		world.cellMemory->push_back(tree.aliveCells, {x, 0});
+		CURSED_TREES_PROFILE_COUNT(world, nodesAllocated, 1);
 		reg.emplace<Living>(entity, Living{ 
-				.colorIndex = Random::get(1, 6), 
+				.colorIndex = world.random.get(1, 6), 
 				.age = 0, 
-				.maxAge = Random::get(minMaxAge, maxMaxAge)
+				.maxAge = world.random.get(world.params.minMaxAge, world.params.maxMaxAge)
 			});
 		entt::entity cell = world.at({x, 0});
-		reg.remove_if_exists<Cell>(cell);
-		reg.emplace<Cell>(cell, entity, byte{0u}, Cell::Type::ACTIVE);
+		if (auto pOld = reg.try_get<Cell>(cell))
+		{
+			world.hashCell({x, 0}, *pOld);
+			reg.remove<Cell>(cell);
+		}
+		world.hashCell({x, 0}, reg.emplace<Cell>(cell, entity, byte{0u}, Cell::Type::ACTIVE));
 		return tree;
 	}
 
@@ -37,6 +65,7 @@ namespace game
 	{
 		auto& reg = world.registry;
 		auto& tree = reg.get<Tree>(entity);
+		int grown = 0;
 		for (auto it = tree.aliveCells.begin(); it != tree.aliveCells.end();)
 		{
 			Vector2 pos = *it;
@@ -45,31 +74,69 @@ namespace game
 			auto& currentGene = tree.genom.getGenes()[cell.activeGene];
 			bool growed = false;
 			visitDirections([&](Direction dir) -> void {
+				byte nextGene = currentGene.proteins[static_cast<byte>(dir)].nextGene;
+				if (world.border && ((dir == Direction::LEFT && pos.x == 0) ||
+									 (dir == Direction::RIGHT && pos.x == world.w-1)))
+				{
+					/* the neighbouring stripe gets a tree of its own */
+					auto side = dir == Direction::LEFT ? Border::LEFT : Border::RIGHT;
+					auto&& occupied = world.border->occupied[side][pos.y];
+					if (nextGene < Genom::num_genes && !occupied && tree.genom.grows(world, cell, dir, pos))
+					{
+						int share = tree.energy / static_cast<int>(tree.aliveCells.size() + 1);
+						world.hashTree(entity, tree.energy);
+						tree.energy -= share;
+						world.hashTree(entity, tree.energy);
+						world.population.energy -= share;
+						auto& living = reg.get<Living>(entity);
+						world.border->buds[side].push_back(Bud{
+								.y = pos.y,
+								.activeGene = nextGene,
+								.energy = share,
+								.age = living.age + 1, /* as old as the tree after this year */
+								.maxAge = living.maxAge,
+								.genom = tree.genom
+							});
+						occupied = true;
+						growed = true;
+						grown++;
+					}
+					return;
+				}
 				Vector2 newPos;
 				if (dir == Direction::LEFT && pos.x == 0) newPos = {world.w-1, pos.y};
 				else if (dir == Direction::RIGHT && pos.x == world.w-1) newPos = {0, pos.y};
 				else newPos = pos.offset(dir);
-				byte nextGene = currentGene.proteins[static_cast<byte>(dir)].nextGene;
 				if (newPos.x < world.w && newPos.y < world.h && nextGene < Genom::num_genes)
 				{
 					entt::entity near = world.at(newPos);
 					if (!reg.any_of<Cell>(near) && 
 						tree.genom.grows(world, cell, dir, pos))
 					{
-						reg.emplace<Cell>(near, cell).activeGene = nextGene;
-						tree.aliveCells.push_front(newPos);
+						auto& newCell = reg.emplace<Cell>(near, cell);
+						newCell.activeGene = nextGene;
+						world.hashCell(newPos, newCell);
+						world.cellMemory->push_front(tree.aliveCells, newPos);
+						CURSED_TREES_PROFILE_COUNT(world, cellsGrown, 1);
+						CURSED_TREES_PROFILE_COUNT(world, nodesAllocated, 1);
 						growed = true;
+						grown++;
 					}
 				}
 			});
 			if (growed)
 			{
-				tree.deadCells.push_back(pos);
+				world.hashCell(pos, cell);
 				cell.type = Cell::Type::DEAD;
-				it = tree.aliveCells.erase(it);
+				world.hashCell(pos, cell);
+				it = world.cellMemory->move(tree.aliveCells, it, tree.deadCells);
+				CURSED_TREES_PROFILE_COUNT(world, nodesAllocated, 1);
+				CURSED_TREES_PROFILE_COUNT(world, nodesFreed, 1);
 			}
 			else ++it;
 		}
+		if (grown)
+			world.emit(TreeEvent::Type::GROW, tree.root(), entity, grown);
 		reg.get<Living>(entity).age++;
 	}
 
@@ -77,15 +144,37 @@ namespace game
 	{
 		auto& reg = world.registry;
 		Tree& tree = reg.get<Tree>(entity);
+		if (tree.aliveCells.empty()) /* all of its growth budded off to other stripes */
+			[[unlikely]]
+			return destroy(world, entity);
 		for (auto& pos : tree.deadCells)
+		{
+			world.hashCell(pos, reg.get<Cell>(world.at(pos)));
 			reg.remove<Cell>(world.at(pos));
+		}
+		world.hashTree(entity, tree.energy);
+		world.population.died(tree.genom, world.year - reg.get<Living>(entity).age);
+		const auto parent = tree.lineage;
+		world.emit(TreeEvent::Type::KILL, tree.root(), entity, static_cast<std::int32_t>(tree.aliveCells.size()));
 		int averageEnergy = tree.energy / tree.aliveCells.size();
+		world.population.energy += static_cast<long long>(averageEnergy) * tree.aliveCells.size() - tree.energy;
+		CURSED_TREES_PROFILE_COUNT(world, seedsSpawned, tree.aliveCells.size());
+		CURSED_TREES_PROFILE_COUNT(world, nodesAllocated, tree.aliveCells.size());
+		CURSED_TREES_PROFILE_COUNT(world, nodesFreed, tree.aliveCells.size() + tree.deadCells.size());
 		for (auto& pos : tree.aliveCells)
 		{
 			entt::entity seed = reg.create();
-			reg.emplace<Tree>(seed, averageEnergy, tree.genom.clone())
-				.aliveCells.push_back(pos);
+			byte mutated;
+			auto& seedTree = reg.emplace<Tree>(seed, averageEnergy,
+											   tree.genom.clone(world.random, world.params.mutationChance, &mutated),
+											   *world.cellMemory);
+			world.cellMemory->push_back(seedTree.aliveCells, pos);
+			if (world.lineage)
+				seedTree.lineage = world.lineage->seed(world.year, parent, mutated, seedTree.genom);
+			if (mutated < Genom::num_genes)
+				world.emit(TreeEvent::Type::MUTATION, pos, seed, mutated);
 			reg.emplace<Falling>(seed);
+			world.hashTree(seed, averageEnergy);
 			if (!reg.all_of<Cell>(world.at(pos)))
 			{
 				if (!reg.valid(world.at(pos)))
@@ -100,9 +189,15 @@ namespace game
 				throw std::runtime_error("Found undefined entity");
 			}
 			auto& cell = reg.get<Cell>(world.at(pos));
+			world.hashCell(pos, cell);
 			cell.parent = seed;
 			cell.activeGene = 0;
+			world.hashCell(pos, cell);
 		}
+		if (world.lineage)
+			world.lineage->died(world.year, parent, Lineage::Death::OLD);
+		world.cellMemory->release(tree.aliveCells);
+		world.cellMemory->release(tree.deadCells);
 		reg.destroy(entity);
 	}
 
@@ -110,25 +205,69 @@ namespace game
 	{
 		auto& reg = world.registry;
 		auto& tree = reg.get<Tree>(entity);
-		for (auto& pos : tree.aliveCells)
-			reg.remove<Cell>(world.at(pos));
-		for (auto& pos : tree.deadCells)
-			reg.remove<Cell>(world.at(pos));
+		auto pLiving = reg.try_get<Living>(entity);
+		/* falling seeds are reported by World::physics */
+		if (pLiving)
+			world.emit(TreeEvent::Type::DESTROY, tree.root(), entity, tree.energy);
+		for (auto* cells : {&tree.aliveCells, &tree.deadCells})
+			for (auto& pos : *cells)
+			{
+				world.hashCell(pos, reg.get<Cell>(world.at(pos)));
+				reg.remove<Cell>(world.at(pos));
+			}
+		world.hashTree(entity, tree.energy);
+		world.population.energy -= tree.energy;
+		if (pLiving)
+			world.population.died(tree.genom, world.year - pLiving->age);
+		if (world.lineage)
+			world.lineage->died(world.year, tree.lineage, pLiving ? Lineage::Death::DESTROYED : Lineage::Death::SEED);
+		CURSED_TREES_PROFILE_COUNT(world, nodesFreed, tree.aliveCells.size() + tree.deadCells.size());
+		world.cellMemory->release(tree.aliveCells);
+		world.cellMemory->release(tree.deadCells);
 		reg.destroy(entity);
 	}
 
+	bool Tree::bud(World& world, unsigned int x, const Bud& bud)
+	{
+		auto& reg = world.registry;
+		entt::entity cell = world.at({x, bud.y});
+		if (reg.any_of<Cell>(cell))
+			return false;
+		entt::entity entity = reg.create();
+		auto& tree = reg.emplace<Tree>(entity, bud.energy, bud.genom, *world.cellMemory);
+		world.hashTree(entity, bud.energy);
+		world.population.energy += bud.energy;
+		world.population.born(tree.genom, world.year - bud.age);
+		/* its parent is in another stripe's world */
+		if (world.lineage)
+			tree.lineage = world.lineage->founder(world.year, tree.genom);
+		world.emit(TreeEvent::Type::SPAWN, {x, bud.y}, entity, bud.energy);
+		world.cellMemory->push_back(tree.aliveCells, {x, bud.y});
+		CURSED_TREES_PROFILE_COUNT(world, nodesAllocated, 1);
+		reg.emplace<Living>(entity, Living{
+				.colorIndex = world.random.get(1, 6),
+				.age = bud.age,
+				.maxAge = bud.maxAge
+			});
+		world.hashCell({x, bud.y}, reg.emplace<Cell>(cell, entity, bud.activeGene, Cell::Type::ACTIVE));
+		return true;
+	}
+
 	void Tree::plant(World& world, entt::entity entity)
 	{
 		auto& reg = world.registry;
 		reg.remove<Falling>(entity);
+		CURSED_TREES_PROFILE_COUNT(world, seedsPlanted, 1);
+		auto& tree = reg.get<Tree>(entity);
+		world.population.born(tree.genom, world.year);
+		if (world.lineage)
+			world.lineage->plant(world.year, tree.lineage);
+		world.emit(TreeEvent::Type::PLANT, tree.aliveCells.front(), entity);
 		reg.emplace<Living>(entity, Living{ 
-				.colorIndex = Random::get(1, 6), 
+				.colorIndex = world.random.get(1, 6), 
 				.age = 0,
-				.maxAge = Random::get(minMaxAge, maxMaxAge)
+				.maxAge = world.random.get(world.params.minMaxAge, world.params.maxMaxAge)
 			});
 	}
-
-	int Tree::minMaxAge = 80;
-	int Tree::maxMaxAge = 90;
 }
 
@@ -1,30 +1,39 @@
 #pragma once
 
+#include "CellMemory.hpp"
 #include "Components.hpp"
 #include "Genetic.hpp"
 
-#include <list>
-
-#include <lida/MemoryPool.hpp>
-
 namespace game
 {
 	class World;
+	struct Bud;
 
 	class Tree
 	{
 	public:
 		int energy;
 		/* list with tree's active cells */
-		std::list<Vector2, lida::MemoryPool<Vector2>> aliveCells;
+		CellMemory::List aliveCells;
         /* list with tree's dead cells */
-		std::list<Vector2, lida::MemoryPool<Vector2>> deadCells;
+		CellMemory::List deadCells;
 
 		Genom genom;
+		/* id in World::lineage, 0 when lineage isn't recorded */
+		std::uint64_t lineage = 0;
+
+		/* lists are changed through @a memory, see CellMemory */
+		Tree(int energy, const Genom& genom, CellMemory& memory);
+		/* copy of @a tree whose lists take memory from @a memory */
+		Tree(const Tree& tree, CellMemory& memory);
+
+		/* cell the tree grew from or the seed itself */
+		Vector2 root() const;
 
-		Tree(int energy, const Genom& genom = {});
 		/* spawn a tree at the bottom of world */
 		static Tree& spawn(World& world, unsigned int x, int energy = 300);
+		/* spawn a tree with @a genom at the bottom of world */
+		static Tree& spawn(World& world, unsigned int x, int energy, const Genom& genom);
 		/* grow tree by cloning it cells */
 		static void grow(World& world, entt::entity tree);
 		/* kill tree, all cells will become seeds */
@@ -33,10 +42,7 @@ namespace game
 		static void destroy(World& world, entt::entity tree);
 		/* plant a seed */
 		static void plant(World& world, entt::entity tree);
-
-		/* default value is 80 */
-		static int minMaxAge;
-		/* default value is 90 */
-		static int maxMaxAge;
+		/* grow a tree from a bud at edge column x, false if the tile is taken */
+		static bool bud(World& world, unsigned int x, const Bud& bud);
 	};
 }
@@ -1,18 +1,78 @@
 #include "World.hpp"
+#include "Locality.hpp"
+#include "Trace.hpp"
 #include "Tree.hpp"
 
+#include <algorithm>
 #include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
 #include <entt/entity/handle.hpp>
 
 namespace game
 {
-	World::World(entt::registry& registry, unsigned int w, unsigned int h)
-		: field(new entt::entity[w*h]), registry(registry), w(w), h(h)
+	void validate_parameters(const Parameters& params)
 	{
+		if (params.minMaxAge > params.maxMaxAge)
+			throw std::invalid_argument("Minimal age of trees " + std::to_string(params.minMaxAge)
+										+ " is greater than maximal one " + std::to_string(params.maxMaxAge));
+	}
+
+	World::World(entt::registry& registry, unsigned int w, unsigned int h, const Parameters& params)
+		: registry(registry), w(w), h(h), params(params)
+		, population(std::max(params.minMaxAge, params.maxMaxAge)), cellMemory(std::make_unique<CellMemory>())
+	{
+		validate_parameters(params);
+		if (this->params.seed == 0)
+			this->params.seed = std::random_device{}();
+		random.seed(this->params.seed);
 		registry.reserve<Cell>((w * h) >> 1); /* There will be a lot of cells */
 		registry.reserve<Tree>((w * h) >> 2); /* and trees */
+		std::shared_ptr<entt::entity[]> tiles(new entt::entity[w*h]);
 		for (unsigned int i = 0; i < w * h; i++)
-			field[i] = registry.create();
+			tiles[i] = registry.create();
+		field = std::move(tiles);
+	}
+
+	/* copy every component of type T in storage order, so views iterate them in the same order,
+	   @a args are passed to constructor of copies after the original */
+	template<typename T, typename... Args>
+	static void copy_storage(const entt::registry& from, entt::registry& to, Args&... args)
+	{
+		const auto size = from.size<T>();
+		const entt::entity* entities = from.data<T>();
+		const T* components = from.raw<T>();
+		to.reserve<T>(std::max(size, from.capacity<T>()));
+		for (std::size_t i = 0; i < size; i++)
+			to.emplace<T>(entities[i], components[i], args...);
+	}
+
+	World::World(entt::registry& registry, const World& parent)
+		: field(parent.field), registry(registry), w(parent.w), h(parent.h)
+		, params(parent.params), random(parent.random), profile(parent.profile), hash(parent.hash)
+		, year(parent.year), population(parent.population), history(parent.history)
+		, cellMemory(std::make_unique<CellMemory>())
+	{
+		/* identifiers of alive and destroyed entities, so new ones are recycled the same way */
+		registry.assign(parent.registry.data(), parent.registry.data() + parent.registry.size(),
+						parent.registry.destroyed());
+		copy_storage<Cell>(parent.registry, registry);
+		copy_storage<Tree>(parent.registry, registry, *cellMemory);
+		copy_storage<Living>(parent.registry, registry);
+		copy_storage<Falling>(parent.registry, registry);
+	}
+
+	World World::fork(entt::registry& target) const
+	{
+		CURSED_TREES_TRACE("World::fork");
+		if (&target == &registry)
+			throw std::invalid_argument("fork needs its own registry");
+		if (target.alive() > 0)
+			throw std::invalid_argument("fork needs an empty registry");
+		if (border)
+			throw std::invalid_argument("stripes can't be forked");
+		return World(target, *this);
 	}
 
 	World::~World() noexcept
@@ -22,14 +82,16 @@ namespace game
 			registry.clear<Tree>();
 			for (unsigned int i = 0; i < w * h; i++)
 				registry.destroy(field[i]);
-			delete[] field;
 		}
 	}
 
 	World::World(World&& world) noexcept
-		: field(world.field), registry(world.registry), w(world.w), h(world.h)
+		: field(std::move(world.field)), registry(world.registry), w(world.w), h(world.h)
+		, params(world.params), random(std::move(world.random)), profile(world.profile), hash(world.hash)
+		, year(world.year), population(std::move(world.population)), history(world.history)
+		, cellMemory(std::move(world.cellMemory))
+		, border(world.border), lineage(world.lineage), events(world.events), hooks(world.hooks)
 	{
-		world.field = nullptr;
 	}
 
 	World& World::operator=(World&& world) noexcept
@@ -48,11 +110,30 @@ namespace game
 		return field[pos.y * w + pos.x];
 	}
 
-	void World::sun(int min, unsigned int levels)
+	std::uint64_t World::computeHash() const
 	{
+		std::uint64_t result = 0;
+		for (unsigned int y = 0; y < h; y++)
+			for (unsigned int x = 0; x < w; x++)
+				if (auto pCell = registry.try_get<Cell>(at({x, y})))
+					result ^= cellKey({x, y}, *pCell);
+		for (auto&& [entity, tree] : registry.view<Tree>().each())
+			result ^= treeKey(entity, tree.energy);
+		return result;
+	}
+
+	void World::sun()
+	{
+		CURSED_TREES_TRACE("World::sun");
+		const auto columns = hooks ? hooks->sun(*this) : std::span<const int>{};
+		const int* light = columns.size() == w ? columns.data() : nullptr;
+		/* every tree's energy changes, so rehash all of them once instead of every change */
+		for (auto&& [entity, tree] : registry.view<Tree>().each())
+			hashTree(entity, tree.energy);
 		for (unsigned int x = 0; x < w; x++)
 		{
-			unsigned int level = levels, height = h;
+			const int min = light ? light[x] : params.minSun;
+			unsigned int level = params.sunLevels, height = h;
 			entt::entity current;
 			while (level && height)
 			{
@@ -62,18 +143,25 @@ namespace game
 				{
 					auto& tree = registry.get<Tree>(registry.get<Cell>(current).parent);
 					tree.energy += level * (height + min);
+					population.energy += level * (height + min);
 					level--;
 				}
 			}
 		}
 		for (auto&& [entity, cell] : registry.view<Cell>().each())
-			registry.get<Tree>(cell.parent).energy -= 10;
+			registry.get<Tree>(cell.parent).energy -= params.upkeep;
+		population.energy -= static_cast<long long>(params.upkeep) * registry.size<Cell>();
+		for (auto&& [entity, tree] : registry.view<Tree>().each())
+			hashTree(entity, tree.energy);
+		CURSED_TREES_PROFILE_COUNT(*this, entities[TickProfile::SUN], registry.size<Cell>());
 	}
 
 	void World::physics()
 	{
+		CURSED_TREES_TRACE("World::physics");
 		for (auto&& [entity, tree, falling] : registry.view<Tree, Falling>().each())
 		{
+			CURSED_TREES_PROFILE_COUNT(*this, entities[TickProfile::PHYSICS], 1);
 			Vector2& pos = tree.aliveCells.front();
 			if (pos.y == 0) /* if seed is at the bottom then plant it */
 				[[unlikely]]
@@ -83,13 +171,19 @@ namespace game
 				entt::entity below = at(pos.offset(Direction::DOWN));
 				if (registry.any_of<Cell>(below)) /* destroy falling seed if there is
 													 a Cell bellow */
+				{
+					CURSED_TREES_PROFILE_COUNT(*this, seedsDestroyed, 1);
+					emit(TreeEvent::Type::SEED_DESTROYED, pos, entity);
 					Tree::destroy(*this, entity);
+				}
 				else /* move seed 1 tile down */
 				{
 					entt::entity seed = at(pos);
-					registry.emplace<Cell>(below, std::move(registry.get<Cell>(seed)));
+					const Cell cell = registry.emplace<Cell>(below, std::move(registry.get<Cell>(seed)));
+					hashCell(pos, cell);
 					registry.remove<Cell>(seed);
 					pos.y--;
+					hashCell(pos, cell);
 				}
 			}
 		}
@@ -97,20 +191,65 @@ namespace game
 
 	void World::growTrees()
 	{
+		CURSED_TREES_TRACE("World::growTrees");
 		auto view = registry.view<Tree, Living>();
 		for (auto&& [entity, tree, living] : view.each())
 		{
+			CURSED_TREES_PROFILE_COUNT(*this, entities[TickProfile::GROW], 1);
 			if (tree.energy <= 0) Tree::destroy(*this, entity);
 			else if (living.age >= living.maxAge) Tree::kill(*this, entity);
 			else Tree::grow(*this, entity);
 		}
 	}
 
-	bool World::tick(int min, unsigned int levels)
+	void World::sortTrees()
+	{
+		CURSED_TREES_TRACE("World::sortTrees");
+		sort_trees<Tree>(registry, year);
+	}
+
+	void World::graft()
 	{
-		physics();
-		growTrees();
-		sun(min, levels);
+		CURSED_TREES_TRACE("World::graft");
+		border->exchangeBuds(*this);
+		for (auto side : {Border::LEFT, Border::RIGHT})
+		{
+			const unsigned int x = side == Border::LEFT ? 0 : w - 1;
+			for (auto& bud : border->received[side])
+				Tree::bud(*this, x, bud);
+			border->received[side].clear();
+		}
+	}
+
+	bool World::tick()
+	{
+		CURSED_TREES_TRACE("World::tick");
+		CURSED_TREES_PROFILE_RESET(*this);
+		if (hooks)
+			for (const auto& request : hooks->spawn(*this))
+				if (request.x < w && registry.orphan(at({request.x, 0})))
+					Tree::spawn(*this, request.x, request.energy);
+		{
+			CURSED_TREES_PROFILE_PHASE(*this, PHYSICS);
+			physics();
+		}
+		if (border)
+			border->exchangeEdges(*this);
+		{
+			CURSED_TREES_PROFILE_PHASE(*this, GROW);
+			growTrees();
+		}
+		if (border)
+			graft();
+		{
+			CURSED_TREES_PROFILE_PHASE(*this, SUN);
+			sun();
+		}
+		sortTrees();
+		year++;
+		history.push(gather_statistics(*this));
+		if (hooks)
+			hooks->tickEnd(*this);
 		return registry.size<Tree>() > 0;
 	}
 }
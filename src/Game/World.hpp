@@ -1,31 +1,162 @@
 #pragma once
 
+#include "Border.hpp"
+#include "EventStream.hpp"
+#include "Hooks.hpp"
+#include "Lineage.hpp"
+#include "Profiler.hpp"
+#include "Statistics.hpp"
 #include "Tree.hpp"
 
+#include <cstdint>
+#include <memory>
 #include <entt/entity/fwd.hpp>
 
 namespace game
 {
+	/**
+	 * @brief Tunable constants of a world.
+	 */
+	struct Parameters
+	{
+		/* energy sun gives to cells in addition to their height */
+		int minSun = 5;
+		/* how many cells in a column get sun's energy */
+		unsigned int sunLevels = 3;
+		/* energy each cell costs to its tree every tick */
+		int upkeep = 10;
+		/* multiplier of energy predicates' parameters in genes */
+		int energyScale = 50;
+		/* probability of a seed's genom being mutated */
+		float mutationChance = 0.25f;
+		/* trees live for random number of years in [minMaxAge, maxMaxAge] */
+		int minMaxAge = 80;
+		int maxMaxAge = 90;
+		/* seed of world's random generator, 0 means pick a random one */
+		unsigned int seed = 0;
+	};
+
+	/**
+	 * @brief Check that parameters make sense together.
+	 * @throw std::invalid_argument if minMaxAge is greater than maxMaxAge
+	 */
+	void validate_parameters(const Parameters& params);
+
 	class World
 	{
 	private:
-		entt::entity* field;
+		/* entities of tiles never change, so forks share them */
+		std::shared_ptr<const entt::entity[]> field;
 
 	public:
 		entt::registry& registry;
 		const unsigned int w;
 		const unsigned int h;
+		/* seed is replaced with the actual one when it is 0 */
+		Parameters params;
+		Random random;
+		/* timings and counters of the last tick */
+		TickProfile profile;
+		/**
+		 * Zobrist style hash of cells (position, parent, gene, type) and
+		 * trees' energies. Everything changing them toggles old and new
+		 * state with hashCell()/hashTree(), so it's always current.
+		 */
+		std::uint64_t hash = 0;
+		/* number of ticks simulated */
+		unsigned int year = 0;
+		/* kept up to date like hash, see gather_statistics() */
+		Population population;
+		/* statistics after each of the last ticks, oldest first */
+		History<Statistics, 512> history;
+		/* memory of trees' cell lists, a fork gets its own */
+		std::unique_ptr<CellMemory> cellMemory;
+		/* edges of a stripe of a wider world, nullptr when world wraps around */
+		Border* border = nullptr;
+		/* log of births and deaths, nullptr when it isn't recorded */
+		Lineage* lineage = nullptr;
+		/* stream of tree events, nullptr when nobody consumes them */
+		EventStream* events = nullptr;
+		/* custom spawns, sun and analysis, nullptr when world runs as is */
+		Hooks* hooks = nullptr;
 
-		World(entt::registry& registry, unsigned int w, unsigned int h);
+		/* @throw std::invalid_argument if @a params are invalid, see validate_parameters() */
+		World(entt::registry& registry, unsigned int w, unsigned int h, const Parameters& params = {});
 		~World() noexcept;
 		World(World&& world) noexcept;
 		World& operator=(World&& world) noexcept;
 
+		/**
+		 * @brief Branch off a copy of this world which lives in @a target.
+		 * @detail Entities keep their identifiers, components keep their order
+		 * in storage and random generator keeps its state, so a fork with the
+		 * same parameters ticks exactly like the original. Grid of tiles is
+		 * shared, components are copied in one pass over their storage, cell
+		 * lists of trees are copied to fork's cellMemory. It isn't copy on
+		 * write: a fork takes time and memory proportional to the number of
+		 * trees and cells right away. Storage is packed, so every destroyed
+		 * tree or cell moves the last component into its place, and cell
+		 * lists are linked nodes changed by every growth, so pages shared
+		 * with the original would be copied within a few ticks anyway, while
+		 * every write would pay for checking whether they are shared.
+		 * Fork doesn't write to lineage or events of the original and doesn't
+		 * call its hooks.
+		 * Must be called from the thread simulating this world.
+		 * @param target registry without entities, must outlive the fork
+		 * @throw std::invalid_argument if @a target is this world's registry
+		 * or has entities or world is a stripe
+		 */
+		World fork(entt::registry& target) const;
+
 		entt::entity at(Vector2 pos) const;
 
-		void sun(int min, unsigned int levels);
+		/* push an event to events if they are consumed, never blocks */
+		void emit(TreeEvent::Type type, Vector2 pos, entt::entity tree, std::int32_t value = 0) noexcept
+		{
+			if (events)
+				events->push({type, static_cast<std::uint16_t>(pos.x), static_cast<std::uint16_t>(pos.y),
+							  year, static_cast<std::uint32_t>(tree), value});
+		}
+
+		/* toggle cell at pos in hash, call before and after changing a cell */
+		void hashCell(Vector2 pos, const Cell& cell) noexcept { hash ^= cellKey(pos, cell); }
+		/* toggle tree's energy in hash, call before and after changing it */
+		void hashTree(entt::entity tree, int energy) noexcept { hash ^= treeKey(tree, energy); }
+		/* compute hash from scratch, O(world), for checking the incremental one */
+		std::uint64_t computeHash() const;
+
+		void sun();
 		void physics();
 		void growTrees();
-		bool tick(int min, unsigned int levels);
+		/**
+		 * @brief Order trees in storage by positions of their roots when a lot
+		 * of them are out of order, see sort_trees().
+		 */
+		void sortTrees();
+		/* with border, exchange buds with neighbours and grow trees from received ones */
+		void graft();
+		bool tick();
+
+	private:
+		World(entt::registry& registry, const World& parent);
+
+
+		std::uint64_t cellKey(Vector2 pos, const Cell& cell) const noexcept
+		{
+			std::uint64_t key = mix((std::uint64_t(pos.y * w + pos.x) << 32) | static_cast<std::uint32_t>(cell.parent));
+			return mix(key ^ (cell.activeGene | (static_cast<std::uint64_t>(cell.type) << 8)));
+		}
+		static std::uint64_t treeKey(entt::entity tree, int energy) noexcept
+		{
+			std::uint64_t key = mix(static_cast<std::uint32_t>(tree) | (std::uint64_t(1) << 63));
+			return mix(key ^ static_cast<std::uint32_t>(energy));
+		}
+		/* splitmix64 finalizer */
+		static constexpr std::uint64_t mix(std::uint64_t x) noexcept
+		{
+			x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+			x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+			return x ^ (x >> 31);
+		}
 	};
 }
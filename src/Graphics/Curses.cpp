@@ -28,7 +28,8 @@ namespace graphics
 
 	void shutdown()
 	{
-		endwin();
+		if (!isendwin()) /* may be called again on an error path */
+			endwin();
 	}
 
 	void cursor_set(bool enable)
@@ -108,6 +109,11 @@ namespace graphics
 		else wrefresh(win);
 	}
 
+	void Window::stage()
+	{
+		wnoutrefresh(win);
+	}
+
 	void Window::addchar(char ch) 
 	{
 		waddch(win, ch);
@@ -163,6 +169,14 @@ namespace graphics
 		wclear(win);
 	}
 
+#ifdef erase
+#undef erase
+#endif
+	void Window::erase()
+	{
+		werase(win);
+	}
+
 	void Window::move(int y, int x)
 	{
 		mvwin(win, y, x);
@@ -178,6 +192,11 @@ namespace graphics
 		return Window(::stdscr);
 	}
 
+	void update()
+	{
+		doupdate();
+	}
+
 	void beep()
 	{
 		::beep();
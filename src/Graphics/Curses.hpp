@@ -114,6 +114,10 @@ namespace graphics
 		SPACE = ' ',
 		PLUS = '+',
 		MINUS = '-',
+		LEFT_BRACKET = '[',
+		RIGHT_BRACKET = ']',
+		LESS = '<',
+		GREATER = '>',
 		CODE_YES	= 0400,
 		MIN		= 0401,
 		BREAK	= 0401,
@@ -289,6 +293,12 @@ namespace graphics
 		 * @brief Equivalent to wrefresh() from `ncurses.h`
 		 */
 		void refresh();
+		/**
+		 * @brief Equivalent to wnoutrefresh() from `ncurses.h`.
+		 * @detail Copies window to the virtual screen without
+		 * touching the terminal, call graphics::update() to flush.
+		 */
+		void stage();
 		void addchar(char ch);
 		void mvaddchar(int y, int x, char ch);
 		void print(std::string_view str);
@@ -321,6 +331,11 @@ namespace graphics
 		void nodelay(bool enable);
 		void border(const Border& border);
 		void clear();
+		/**
+		 * @brief Same to werase from `ncurses.h`, unlike clear() doesn't
+		 * force repainting of whole terminal on next refresh.
+		 */
+		void erase();
 		void move(int y, int x);
 		void resize(int h, int w);
 
@@ -333,5 +348,11 @@ namespace graphics
 	[[nodiscard]]
 	Window stdscr();
 
+	/**
+	 * @brief Same to doupdate from `ncurses.h`, flushes all staged windows
+	 * to terminal at once.
+	 */
+	void update();
+
 	void beep();
 }
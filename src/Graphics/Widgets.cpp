@@ -1,5 +1,7 @@
 #include "Widgets.hpp"
 
+#include <algorithm>
+
 namespace graphics
 {
 	void widgets::print_in_middle(Window& window, int y, std::string_view str)
@@ -34,6 +36,7 @@ namespace graphics
 	widgets::LinePrinter::LinePrinter(int w, int y, int x)
 		: Window{1, w, y, x}
 		, frame_counter{0}
+		, changed{true}
 	{
 		
 	}
@@ -42,8 +45,14 @@ namespace graphics
 	{
 		int width = Window::width();
 		int sz = message.size();
+		if (!changed && width >= sz) /* Nothing to redraw, scrolled messages
+									  * change every frame though.
+									  */
+			return;
+		changed = false;
+
 		std::string_view view = message;
-		clear();
+		erase();
 		if (width < sz) /* Message doesn't fit the window so we scroll it
 						 * horizontally.
 						 */
@@ -62,12 +71,13 @@ namespace graphics
 			}
 		}
 		mvprint(0, 0, view);
-		refresh();
+		stage();
 		frame_counter++;
 	}
 
 	void widgets::LinePrinter::draw(const ColorPair& color, int space_between_parts)
 	{
+		changed = true;
 		on(color);
 		draw(space_between_parts);
 		off(color);
@@ -75,21 +85,108 @@ namespace graphics
 
 	widgets::PropertyLine::PropertyLine(int w, int y, int x)
 		: Window(1, w, y, x)
+		, changed(true)
 	{
 		
 	}
 
+	void widgets::PropertyLine::set(int pos, std::string str)
+	{
+		auto [it, inserted] = properties.try_emplace(pos);
+		if (!inserted && it->second == str)
+			return;
+		it->second = std::move(str);
+		changed = true;
+	}
+
+	void widgets::PropertyLine::remove(int pos)
+	{
+		if (properties.erase(pos))
+			changed = true;
+	}
+
 	void widgets::PropertyLine::draw()
 	{
-		Window::clear();
+		if (!changed)
+			return;
+		changed = false;
+
+		Window::erase();
 		for (auto&& [pos, str] : properties)
 				mvprint(0, pos, str);
-		refresh();
+		stage();
+	}
+
+	widgets::Sparkline::Sparkline(int w, int y, int x)
+		: Window(1, w, y, x)
+		, changed(true)
+	{
+
+	}
+
+	void widgets::Sparkline::set(int pos, Series s)
+	{
+		auto [it, inserted] = series.try_emplace(pos);
+		if (!inserted && it->second == s)
+			return;
+		it->second = std::move(s);
+		changed = true;
+	}
+
+	void widgets::Sparkline::set(int pos, std::string label, std::vector<double> values, int width)
+	{
+		if (static_cast<int>(values.size()) > width)
+			values.erase(values.begin(), values.end() - width);
+		set(pos, Series{std::move(label), std::move(values), width, false});
+	}
+
+	void widgets::Sparkline::setHistogram(int pos, std::string label, std::vector<double> values)
+	{
+		int width = values.size();
+		set(pos, Series{std::move(label), std::move(values), width, true});
+	}
+
+	void widgets::Sparkline::remove(int pos)
+	{
+		if (series.erase(pos))
+			changed = true;
+	}
+
+	void widgets::Sparkline::draw()
+	{
+		if (!changed)
+			return;
+		changed = false;
+
+		/* from the lowest bar to the highest one */
+		static constexpr std::string_view bars = "_.-=+*#";
+		Window::erase();
+		for (auto&& [pos, s] : series)
+		{
+			mvprint(0, pos, s.label);
+			if (s.values.empty())
+				continue;
+			auto [pMin, pMax] = std::minmax_element(s.values.begin(), s.values.end());
+			double low = s.fromZero ? 0.0 : *pMin, range = *pMax - low;
+			int x = pos + s.label.size() + s.width - s.values.size();
+			for (double value : s.values)
+			{
+				std::size_t bar = bars.size() / 2; /* flat series */
+				if (range > 0.0)
+					bar = std::min<std::size_t>((value - low) / range * bars.size(), bars.size() - 1);
+				if (s.fromZero && value <= 0.0)
+					mvaddchar(0, x++, ' ');
+				else
+					mvaddchar(0, x++, bars[bar]);
+			}
+		}
+		stage();
 	}
 
 	widgets::Screen::Screen()
 		: header_line(stdscr().width(), 0, 0)
 		, surface(stdscr().height() - 2, stdscr().width(), 1, 0)
+		, graph_line(stdscr().width(), stdscr().height() - 2, 0)
 		, message_line(stdscr().width(), stdscr().height() - 1, 0)
 	{
 		
@@ -97,20 +194,38 @@ namespace graphics
 
 	void widgets::Screen::draw()
 	{
-		message_line.draw();
 		header_line.draw();
-		surface.refresh();
+		surface.stage();
+		if (graph)
+			graph_line.draw();
+		message_line.draw();
+		update();
 	}
 
-	void widgets::Screen::resize()
+	void widgets::Screen::layout()
 	{
 		auto w = stdscr().width();
 		auto h = stdscr().height();
 		header_line.resize(1, w);
-		surface.resize(h - 2, w);
+		surface.resize(h - (graph ? 3 : 2), w);
+		graph_line.move(h - 2, 0);
+		graph_line.resize(1, w);
 		message_line.move(h -1, 0);
 		message_line.resize(1, w);
-		message_line.print("Resized screen to [{}, {}].", w, h);
+		header_line.invalidate();
+		graph_line.invalidate();
+	}
+
+	void widgets::Screen::resize()
+	{
+		layout();
+		message_line.print("Resized screen to [{}, {}].", stdscr().width(), stdscr().height());
+	}
+
+	void widgets::Screen::showGraph(bool show)
+	{
+		graph = show;
+		layout();
 	}
 
 	widgets::VerticalScrollBar::VerticalScrollBar(int height, int y, int x)
@@ -138,7 +253,7 @@ namespace graphics
 		for (int i = top; i <= bottom; i++)
 			mvaddchar(i, 0, '|');
 		mvaddchar(height() - 1, 0, 'v');
-		refresh();
+		stage();
 	}
 
 	widgets::HorizontalScrollBar::HorizontalScrollBar(int width, int y, int x)
@@ -166,6 +281,6 @@ namespace graphics
 		for (int i = left; i <= right; i++)
 			mvaddchar(0, i, '-');
 		mvaddchar(0, width() - 1, '>');
-		refresh();
+		stage();
 	}
 }
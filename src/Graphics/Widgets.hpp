@@ -4,6 +4,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace graphics
 {
@@ -23,11 +24,18 @@ namespace graphics
 		}
 		void status_load(Window& window, int y, int x, int frameNo);
 
+		/**
+		 * @brief One line window which prints a message, scrolls it
+		 * horizontally if it doesn't fit.
+		 * @note draw() only stages the window, call graphics::update() to
+		 * flush it.
+		 */
 		class LinePrinter : public Window
 		{
 		private:
 			std::string message;
 			unsigned frame_counter;
+			bool changed;
 
 		public:
 			LinePrinter(int w, int y, int x);
@@ -39,19 +47,110 @@ namespace graphics
 			void print(std::string_view fmt, A&&... args)
 			{
 				message = fmt::format(fmt, std::forward<A>(args)...);
-				clear();
 				frame_counter = 0;
+				changed = true;
 			}
+
+			/**
+			 * @brief Force redrawing on next draw() call.
+			 */
+			void invalidate() { changed = true; }
+			/**
+			 * @brief Whether message is scrolled and thus changes every frame.
+			 */
+			[[nodiscard]]
+			bool animated() const { return width() < static_cast<int>(message.size()); }
 		};
 
+		/**
+		 * @brief One line window with strings placed at fixed columns.
+		 * @note draw() only stages the window, call graphics::update() to
+		 * flush it.
+		 */
 		class PropertyLine : public Window
 		{
-		public:
+		private:
 			std::map<int, std::string> properties;
+			bool changed;
 
+		public:
 			PropertyLine(int w, int y, int x);
 
+			/**
+			 * @brief Place @a str at column @a pos, does nothing if it
+			 * is already there.
+			 */
+			void set(int pos, std::string str);
+			/**
+			 * @brief Same to set() but with {fmt} library's formatting.
+			 */
+			template<typename... A>
+			void set(int pos, std::string_view fmt, A&&... args)
+			{
+				set(pos, fmt::format(fmt, std::forward<A>(args)...));
+			}
+			/**
+			 * @brief Remove property at column @a pos.
+			 */
+			void remove(int pos);
+
 			void draw();
+
+			/**
+			 * @brief Force redrawing on next draw() call.
+			 */
+			void invalidate() { changed = true; }
+		};
+
+		/**
+		 * @brief One line window with series of values drawn as bars
+		 * at fixed columns, newest values at the right.
+		 * @note draw() only stages the window, call graphics::update() to
+		 * flush it.
+		 */
+		class Sparkline : public Window
+		{
+		private:
+			struct Series
+			{
+				std::string label;
+				std::vector<double> values;
+				int width;
+				/* bars grow from zero instead of from the smallest value */
+				bool fromZero;
+
+				bool operator==(const Series&) const = default;
+			};
+			std::map<int, Series> series;
+			bool changed;
+
+			void set(int pos, Series s);
+
+		public:
+			Sparkline(int w, int y, int x);
+
+			/**
+			 * @brief Place @a label and last @a width of @a values at
+			 * column @a pos, bars span from the smallest value to the
+			 * largest one.
+			 */
+			void set(int pos, std::string label, std::vector<double> values, int width);
+			/**
+			 * @brief Place @a label and a bar for each of @a values at
+			 * column @a pos, bars start from zero.
+			 */
+			void setHistogram(int pos, std::string label, std::vector<double> values);
+			/**
+			 * @brief Remove series at column @a pos.
+			 */
+			void remove(int pos);
+
+			void draw();
+
+			/**
+			 * @brief Force redrawing on next draw() call.
+			 */
+			void invalidate() { changed = true; }
 		};
 
 		class Screen
@@ -59,13 +158,30 @@ namespace graphics
 		public:
 			PropertyLine header_line;
 			Window surface;
+			/* shown above message line by showGraph() */
+			Sparkline graph_line;
 			LinePrinter message_line;
 
 			Screen();
 
+			/**
+			 * @brief Stage all changed widgets and flush them to
+			 * terminal with one graphics::update() call.
+			 */
 			void draw();
 
 			void resize();
+			/**
+			 * @brief Show or hide graph line, surface shrinks by a line
+			 * while it is shown.
+			 */
+			void showGraph(bool show);
+			bool graphShown() const { return graph; }
+
+		private:
+			bool graph = false;
+
+			void layout();
 		};
 
 		class VerticalScrollBar : public Window
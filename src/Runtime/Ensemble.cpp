@@ -0,0 +1,229 @@
+#include "Ensemble.hpp"
+#include "Jobs.hpp"
+#include "Game/Statistics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <entt/entity/registry.hpp>
+#include <fmt/core.h>
+
+namespace runtime
+{
+	namespace
+	{
+		struct Sweep
+		{
+			std::string name;
+			std::vector<std::string> values;
+		};
+
+		struct Run
+		{
+			std::size_t set = 0;
+			unsigned int seed = 0;
+			int ticks = 0;
+			bool extinct = false;
+			game::Statistics stats;
+			double seconds = 0.0;
+		};
+
+		Sweep parse_sweep(const std::string& str)
+		{
+			auto eq = str.find('=');
+			if (eq == std::string::npos || eq == 0 || eq + 1 == str.size())
+				throw std::invalid_argument("Sweep must look like name=value1,value2,...: " + str);
+			Sweep sweep{str.substr(0, eq), {}};
+			for (std::size_t begin = eq + 1; begin <= str.size();)
+			{
+				auto end = std::min(str.find(',', begin), str.size());
+				sweep.values.push_back(str.substr(begin, end - begin));
+				begin = end + 1;
+			}
+			return sweep;
+		}
+
+		struct Summary
+		{
+			double mean = 0.0, sd = 0.0;
+		};
+
+		template<typename F>
+		Summary summarize(const std::vector<const Run*>& runs, F&& field)
+		{
+			Summary s;
+			for (auto run : runs)
+				s.mean += field(*run);
+			s.mean /= runs.size();
+			for (auto run : runs)
+				s.sd += (field(*run) - s.mean) * (field(*run) - s.mean);
+			s.sd = runs.size() > 1 ? std::sqrt(s.sd / (runs.size() - 1)) : 0.0;
+			return s;
+		}
+	}
+
+	void set_parameter(game::Parameters& params, std::string_view name, std::string_view value)
+	{
+		static constexpr std::string_view names[] = {
+			"min-sun", "sun-levels", "upkeep", "energy-scale",
+			"mutation-chance", "min-age", "max-age", "seed"
+		};
+		if (std::find(std::begin(names), std::end(names), name) == std::end(names))
+			throw std::invalid_argument("Unknown parameter " + std::string(name));
+
+		std::string str{value};
+		std::size_t end = 0;
+		try
+		{
+			if (name == "min-sun") params.minSun = std::stoi(str, &end);
+			else if (name == "sun-levels") params.sunLevels = std::stoul(str, &end);
+			else if (name == "upkeep") params.upkeep = std::stoi(str, &end);
+			else if (name == "energy-scale") params.energyScale = std::stoi(str, &end);
+			else if (name == "mutation-chance") params.mutationChance = std::stof(str, &end);
+			else if (name == "min-age") params.minMaxAge = std::stoi(str, &end);
+			else if (name == "max-age") params.maxMaxAge = std::stoi(str, &end);
+			else if (name == "seed") params.seed = std::stoul(str, &end);
+		}
+		catch (const std::logic_error&) /* std::stoi and friends throw invalid_argument or out_of_range */
+		{
+			end = 0;
+		}
+		if (end == 0 || end != str.size())
+			throw std::invalid_argument("Invalid value of " + std::string(name) + ": " + str);
+	}
+
+	void run_ensemble(const EnsembleOptions& options, void (*populate)(game::World&))
+	{
+		std::vector<Sweep> sweeps;
+		for (auto& str : options.sweeps)
+			sweeps.push_back(parse_sweep(str));
+
+		/* every combination of swept values is a parameter set */
+		std::vector<std::vector<std::string>> sets{{}};
+		for (auto& sweep : sweeps)
+		{
+			std::vector<std::vector<std::string>> expanded;
+			for (auto& set : sets)
+				for (auto& value : sweep.values)
+				{
+					expanded.push_back(set);
+					expanded.back().push_back(value);
+				}
+			sets = std::move(expanded);
+		}
+		std::vector<game::Parameters> params(sets.size(), options.params);
+		for (std::size_t i = 0; i < sets.size(); i++)
+		{
+			for (std::size_t j = 0; j < sweeps.size(); j++)
+				set_parameter(params[i], sweeps[j].name, sets[i][j]);
+			/* fail before any run, not in a worker in the middle of them */
+			try
+			{
+				game::validate_parameters(params[i]);
+			}
+			catch (const std::invalid_argument& e)
+			{
+				throw std::invalid_argument(fmt::format("Set {}: {}", i, e.what()));
+			}
+		}
+
+		/* swept seed is the seed of first run of its sets */
+		const bool seedSwept = std::any_of(sweeps.begin(), sweeps.end(), [](const Sweep& sweep) {
+			return sweep.name == "seed";
+		});
+		const unsigned int baseSeed = options.params.seed ? options.params.seed : std::random_device{}();
+		std::vector<Run> runs;
+		for (std::size_t set = 0; set < sets.size(); set++)
+			for (int i = 0; i < options.runs; i++)
+			{
+				const unsigned int seed = (seedSwept ? params[set].seed : baseSeed) + i;
+				auto& run = runs.emplace_back();
+				run.set = set;
+				run.seed = seed ? seed : 1u; /* 0 would mean random seed */
+			}
+
+		register_components();
+		std::size_t finished = 0;
+		std::mutex mutex;
+		run_jobs(runs.size(), options.jobs, [&](std::size_t job) {
+			auto& run = runs[job];
+			using clock = std::chrono::steady_clock;
+			const auto start = clock::now();
+			auto runParams = params[run.set];
+			runParams.seed = run.seed;
+			entt::registry registry;
+			game::World world{registry, options.w, options.h, runParams};
+			populate(world);
+			bool alive = true;
+			while (alive && (options.ticks == 0 || run.ticks < options.ticks))
+			{
+				alive = world.tick();
+				run.ticks++;
+			}
+			run.extinct = !alive;
+			run.stats = game::gather_statistics(world);
+			run.seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+			std::lock_guard lock(mutex);
+			fmt::print(stderr, "[{}/{}] set {} seed {}: {} ticks in {:.2f}s{}\n", ++finished, runs.size(),
+					   run.set, run.seed, run.ticks, run.seconds, run.extinct ? ", extinct" : "");
+		});
+
+		auto print_names = [&](std::FILE* out) {
+			for (auto& sweep : sweeps)
+				fmt::print(out, ",{}", sweep.name);
+		};
+		auto print_values = [&](std::FILE* out, std::size_t set) {
+			for (auto& value : sets[set])
+				fmt::print(out, ",{}", value);
+		};
+
+		if (!options.csvPath.empty())
+		{
+			std::FILE* out = std::fopen(options.csvPath.c_str(), "w");
+			if (!out)
+				throw std::runtime_error("Can't open " + options.csvPath);
+			fmt::print(out, "set,seed");
+			print_names(out);
+			fmt::print(out, ",ticks,extinct,trees,seeds,cells,energy,seconds\n");
+			for (auto& run : runs)
+			{
+				fmt::print(out, "{},{}", run.set, run.seed);
+				print_values(out, run.set);
+				fmt::print(out, ",{},{},{},{},{},{},{:.3f}\n", run.ticks, int(run.extinct), run.stats.trees,
+						   run.stats.seeds, run.stats.cells, run.stats.energy, run.seconds);
+			}
+			std::fclose(out);
+		}
+
+		fmt::print("set");
+		print_names(stdout);
+		fmt::print(",runs,extinct,ticks_mean,trees_mean,trees_sd,cells_mean,cells_sd,energy_mean,energy_sd\n");
+		for (std::size_t set = 0; set < sets.size(); set++)
+		{
+			std::vector<const Run*> setRuns;
+			int extinct = 0;
+			for (auto& run : runs)
+				if (run.set == set)
+				{
+					setRuns.push_back(&run);
+					extinct += run.extinct;
+				}
+			if (setRuns.empty())
+				continue;
+			auto ticks = summarize(setRuns, [](const Run& r) { return double(r.ticks); });
+			auto trees = summarize(setRuns, [](const Run& r) { return double(r.stats.trees); });
+			auto cells = summarize(setRuns, [](const Run& r) { return double(r.stats.cells); });
+			auto energy = summarize(setRuns, [](const Run& r) { return double(r.stats.energy); });
+			fmt::print("{}", set);
+			print_values(stdout, set);
+			fmt::print(",{},{},{:.1f},{:.1f},{:.1f},{:.1f},{:.1f},{:.1f},{:.1f}\n", setRuns.size(), extinct,
+					   ticks.mean, trees.mean, trees.sd, cells.mean, cells.sd, energy.mean, energy.sd);
+		}
+	}
+}
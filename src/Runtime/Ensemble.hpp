@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Game/World.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace runtime
+{
+	struct EnsembleOptions
+	{
+		unsigned int w = 200;
+		unsigned int h = 50;
+		/* parameters of all worlds, seed is the seed of first run */
+		game::Parameters params;
+		/* parameter sweeps like "min-sun=3,5,7", every combination of them is run */
+		std::vector<std::string> sweeps;
+		/* number of runs with different seeds for every combination */
+		int runs = 1;
+		/* ticks to simulate in every run, 0 means until extinction */
+		int ticks = 1000;
+		/* number of worker threads, 0 means one per core */
+		unsigned int jobs = 0;
+		/* file to write results of every single run to in csv format */
+		std::string csvPath;
+	};
+
+	/**
+	 * @brief Run many independent worlds in parallel and print aggregated
+	 * results of every parameter combination to stdout in csv format.
+	 * @detail Run number i of every combination uses seed params.seed + i, so
+	 * combinations are compared on the same seeds. When seed is swept, runs
+	 * of every swept value v use seeds v + i instead.
+	 * @param populate plants initial trees of a world
+	 * @throw std::invalid_argument on malformed sweep or invalid combination
+	 * of parameters
+	 * @throw std::runtime_error if options.csvPath can't be written
+	 */
+	void run_ensemble(const EnsembleOptions& options, void (*populate)(game::World&));
+
+	/**
+	 * @brief Set parameter called @a name to @a value. Names are min-sun,
+	 * sun-levels, upkeep, energy-scale, mutation-chance, min-age, max-age and seed.
+	 * @throw std::invalid_argument if there's no such parameter or value is malformed
+	 */
+	void set_parameter(game::Parameters& params, std::string_view name, std::string_view value);
+}
@@ -0,0 +1,114 @@
+#include "EventWriter.hpp"
+#include "Game/Trace.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <fmt/core.h>
+
+namespace runtime
+{
+	using namespace std::chrono_literals;
+
+	/* binary file is magic, u32 version and then records of record_size bytes,
+	   all numbers are little endian:
+	     offset  0  u8  type, index in type_names
+	     offset  1  u8  0, padding
+	     offset  2  u16 x
+	     offset  4  u16 y
+	     offset  6  u16 0, padding, so the rest is 4 byte aligned
+	     offset  8  u32 year
+	     offset 12  u32 tree
+	     offset 16  i32 value */
+	constexpr char magic[4] = {'C', 'T', 'E', 'V'};
+	constexpr std::uint32_t version = 1;
+	constexpr std::size_t record_size = 20;
+
+	constexpr const char* type_names[] = {
+		"spawn", "plant", "grow", "kill", "destroy", "seed_destroyed", "mutation", "dropped"
+	};
+
+	static void put(unsigned char*& out, std::uint32_t value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++)
+			*out++ = static_cast<unsigned char>(value >> (i * 8));
+	}
+
+	EventWriter::EventWriter(const std::string& filename, std::size_t capacity)
+		: file(std::fopen(filename.c_str(), "wb")), events(capacity)
+	{
+		if (!file)
+			throw std::runtime_error("Can't open " + filename);
+		const std::string_view extension = ".ndjson";
+		ndjson = filename.size() >= extension.size() &&
+			filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+		if (!ndjson)
+		{
+			std::fwrite(magic, 1, sizeof(magic), file);
+			unsigned char bytes[4], *out = bytes;
+			put(out, version, 4);
+			std::fwrite(bytes, 1, sizeof(bytes), file);
+		}
+		thread = std::thread(&EventWriter::run, this);
+	}
+
+	EventWriter::~EventWriter()
+	{
+		stop();
+		std::fclose(file);
+	}
+
+	void EventWriter::stop()
+	{
+		if (!thread.joinable())
+			return;
+		quit.signal();
+		thread.join();
+	}
+
+	void EventWriter::run()
+	{
+		game::trace::name_thread("events");
+		/* the world never wakes the writer, it looks for new events this often */
+		while (!(wait({quit.handle()}, 10ms) & 1))
+			drain();
+		drain();
+		std::fflush(file);
+	}
+
+	void EventWriter::drain()
+	{
+		CURSED_TREES_TRACE("EventWriter::drain");
+		events.drain([this](const game::TreeEvent& event) { write(event); });
+		/* events were dropped while the stream was full, the gap is right after the ones that filled it */
+		const auto drops = events.droppedEvents();
+		if (drops != reportedDrops)
+		{
+			const auto lost = std::min<std::uint64_t>(drops - reportedDrops, std::numeric_limits<std::int32_t>::max());
+			write({game::TreeEvent::Type::DROPPED, 0, 0, 0, 0, static_cast<std::int32_t>(lost)});
+			reportedDrops += lost;
+		}
+	}
+
+	void EventWriter::write(const game::TreeEvent& event)
+	{
+		count++;
+		if (ndjson)
+		{
+			fmt::print(file, "{{\"type\":\"{}\",\"year\":{},\"tree\":{},\"x\":{},\"y\":{},\"value\":{}}}\n",
+					   type_names[static_cast<int>(event.type)], event.year, event.tree, event.x, event.y, event.value);
+			return;
+		}
+		unsigned char bytes[record_size], *out = bytes;
+		put(out, static_cast<std::uint32_t>(event.type), 1);
+		put(out, 0, 1);
+		put(out, event.x, 2);
+		put(out, event.y, 2);
+		put(out, 0, 2);
+		put(out, event.year, 4);
+		put(out, event.tree, 4);
+		put(out, static_cast<std::uint32_t>(event.value), 4);
+		std::fwrite(bytes, 1, sizeof(bytes), file);
+	}
+}
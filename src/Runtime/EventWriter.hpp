@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Events.hpp"
+#include "Game/EventStream.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace runtime
+{
+	/**
+	 * @brief Drains a game::EventStream to a file on its own thread.
+	 * @detail Attach stream() to game::World::events. The world's thread
+	 * never waits for the writer, events it can't keep up with are dropped
+	 * and a DROPPED event with their number is written in their place.
+	 * Format is chosen by file extension: ".ndjson" writes a json object per
+	 * line, anything else writes "CTEV", u32 version and then 20 byte little
+	 * endian records (u8 type, u8 0, u16 x, u16 y, u16 0, u32 year, u32 tree,
+	 * i32 value), see EventWriter.cpp for offsets.
+	 */
+	class EventWriter
+	{
+	public:
+		/**
+		 * @param capacity of the stream, events which fit into it may be
+		 * pushed between two drains
+		 * @throw std::runtime_error if @a filename can't be opened.
+		 */
+		explicit EventWriter(const std::string& filename, std::size_t capacity = 1 << 16);
+		/* writes the remaining events */
+		~EventWriter();
+
+		EventWriter(const EventWriter&) = delete;
+		EventWriter& operator=(const EventWriter&) = delete;
+
+		game::EventStream& stream() noexcept { return events; }
+		/**
+		 * @brief Stop the thread after writing the remaining events, the
+		 * stream must not be pushed to anymore.
+		 */
+		void stop();
+
+		/* events written so far, valid after stop() */
+		std::uint64_t written() const noexcept { return count; }
+		std::uint64_t dropped() const noexcept { return events.droppedEvents(); }
+
+	private:
+		void run();
+		void drain();
+		void write(const game::TreeEvent& event);
+
+		std::FILE* file;
+		bool ndjson;
+		game::EventStream events;
+		EventFd quit;
+		std::thread thread;
+		/* owned by writer thread */
+		std::uint64_t count = 0;
+		std::uint64_t reportedDrops = 0;
+	};
+}
@@ -0,0 +1,104 @@
+#include "Events.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace runtime
+{
+	static std::system_error last_error(const char* what)
+	{
+		return std::system_error(errno, std::generic_category(), what);
+	}
+
+	EventFd::EventFd()
+		: fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+	{
+		if (fd < 0)
+			throw last_error("eventfd");
+	}
+
+	EventFd::~EventFd()
+	{
+		close(fd);
+	}
+
+	void EventFd::signal()
+	{
+		uint64_t one = 1;
+		[[maybe_unused]] auto res = write(fd, &one, sizeof one); /* can fail only if counter overflows */
+	}
+
+	bool EventFd::consume()
+	{
+		uint64_t value;
+		return read(fd, &value, sizeof value) == sizeof value;
+	}
+
+	TimerFd::TimerFd()
+		: fd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC))
+	{
+		if (fd < 0)
+			throw last_error("timerfd_create");
+	}
+
+	TimerFd::~TimerFd()
+	{
+		close(fd);
+	}
+
+	void TimerFd::arm(std::chrono::steady_clock::time_point deadline)
+	{
+		using namespace std::chrono;
+		/* steady_clock is CLOCK_MONOTONIC on Linux */
+		auto ns = duration_cast<nanoseconds>(deadline.time_since_epoch()).count();
+		if (ns <= 0) /* zero would disarm timer */
+			ns = 1;
+		itimerspec spec{};
+		spec.it_value.tv_sec = ns / 1'000'000'000;
+		spec.it_value.tv_nsec = ns % 1'000'000'000;
+		if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0)
+			throw last_error("timerfd_settime");
+	}
+
+	void TimerFd::disarm()
+	{
+		itimerspec spec{};
+		timerfd_settime(fd, 0, &spec, nullptr);
+	}
+
+	bool TimerFd::consume()
+	{
+		uint64_t expirations;
+		return read(fd, &expirations, sizeof expirations) == sizeof expirations;
+	}
+
+	unsigned wait(std::initializer_list<int> fds, std::chrono::milliseconds timeout)
+	{
+		pollfd pfds[8];
+		if (fds.size() > std::size(pfds))
+			throw std::invalid_argument("too many fds to wait for");
+		nfds_t n = 0;
+		for (int fd : fds)
+			pfds[n++] = pollfd{fd, POLLIN, 0};
+		int res = poll(pfds, n, timeout.count() < 0 ? -1 : static_cast<int>(timeout.count()));
+		if (res < 0)
+		{
+			if (errno == EINTR) /* e.g. SIGWINCH, let caller handle it */
+				return 0;
+			throw last_error("poll");
+		}
+		unsigned mask = 0;
+		for (nfds_t i = 0; i < n; i++)
+			if (pfds[i].revents & (POLLIN | POLLHUP | POLLERR))
+				mask |= 1u << i;
+		return mask;
+	}
+}
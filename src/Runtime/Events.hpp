@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <initializer_list>
+
+namespace runtime
+{
+	/**
+	 * @brief A thin wrapper around Linux eventfd. Used to wake up a thread
+	 * blocked in runtime::wait().
+	 */
+	class EventFd
+	{
+	private:
+		int fd;
+
+	public:
+		/**
+		 * @throw std::system_error if eventfd couldn't be created
+		 */
+		EventFd();
+		~EventFd();
+
+		EventFd(const EventFd&) = delete;
+		EventFd& operator=(const EventFd&) = delete;
+
+		[[nodiscard]]
+		int handle() const noexcept { return fd; }
+		void signal();
+		/**
+		 * @brief Reset event.
+		 * @return true if event was signalled.
+		 */
+		bool consume();
+	};
+
+	/**
+	 * @brief A thin wrapper around Linux timerfd on monotonic clock.
+	 */
+	class TimerFd
+	{
+	private:
+		int fd;
+
+	public:
+		/**
+		 * @throw std::system_error if timerfd couldn't be created
+		 */
+		TimerFd();
+		~TimerFd();
+
+		TimerFd(const TimerFd&) = delete;
+		TimerFd& operator=(const TimerFd&) = delete;
+
+		[[nodiscard]]
+		int handle() const noexcept { return fd; }
+		/**
+		 * @brief Make timer fire once at @a deadline.
+		 */
+		void arm(std::chrono::steady_clock::time_point deadline);
+		void disarm();
+		/**
+		 * @brief Reset timer.
+		 * @return true if timer has fired.
+		 */
+		bool consume();
+	};
+
+	/**
+	 * @brief Block current thread until one of @a fds becomes readable or
+	 * @a timeout passes. Negative @a timeout means wait forever.
+	 * @return mask of readable fds, bit i is set if i-th fd is readable.
+	 * Returns 0 on timeout or when interrupted by a signal.
+	 */
+	unsigned wait(std::initializer_list<int> fds, std::chrono::milliseconds timeout = std::chrono::milliseconds{-1});
+}
@@ -0,0 +1,185 @@
+#include "Fitness.hpp"
+#include "Jobs.hpp"
+#include "Game/Serialization.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <entt/entity/registry.hpp>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+namespace runtime
+{
+	namespace
+	{
+		/* what a tree did in one trial */
+		struct Score
+		{
+			int seeds = 0;
+			int peakEnergy = 0;
+			unsigned int height = 0;
+			bool starved = false;
+		};
+
+		constexpr int initial_energy = 300;
+
+		/* plant genomes @a members of a group next to each other and watch them until they die */
+		std::vector<Score> run_group(const FitnessOptions& options, const std::vector<game::Genom>& genomes,
+									 const std::vector<std::size_t>& members, unsigned int seed)
+		{
+			auto params = options.params;
+			params.seed = seed;
+			entt::registry registry;
+			game::World world{registry, options.spacing * static_cast<unsigned int>(members.size()), options.h, params};
+			/* deaths are told by events, the stream is drained after every tick so it never fills up */
+			game::EventStream events(1 << 12);
+			world.events = &events;
+
+			struct Founder
+			{
+				entt::entity entity;
+				Score score;
+				bool alive = true;
+			};
+			std::vector<Founder> founders;
+			for (std::size_t i = 0; i < members.size(); i++)
+			{
+				const unsigned int x = static_cast<unsigned int>(i) * options.spacing + options.spacing / 2;
+				game::Tree::spawn(world, x, initial_energy, genomes[members[i]]);
+				founders.push_back({registry.get<game::Cell>(world.at({x, 0})).parent, {.peakEnergy = initial_energy}});
+			}
+
+			const int lifetime = std::max(params.minMaxAge, params.maxMaxAge);
+			std::size_t alive = founders.size();
+			for (int year = 0; year <= lifetime && alive > 0; year++)
+			{
+				world.tick();
+				events.drain([&](const game::TreeEvent& event) {
+					using Type = game::TreeEvent::Type;
+					if (event.type != Type::KILL && event.type != Type::DESTROY)
+						return;
+					for (auto& founder : founders)
+						if (founder.alive && static_cast<std::uint32_t>(founder.entity) == event.tree)
+						{
+							founder.alive = false;
+							founder.score.seeds = event.type == Type::KILL ? event.value : 0;
+							founder.score.starved = event.type == Type::DESTROY;
+							alive--;
+						}
+				});
+				for (auto& founder : founders)
+				{
+					if (!founder.alive)
+						continue;
+					if (!registry.valid(founder.entity)) /* its death wasn't seen, e.g. the stream was full */
+					{
+						founder.alive = false;
+						alive--;
+						continue;
+					}
+					const auto& tree = registry.get<game::Tree>(founder.entity);
+					founder.score.peakEnergy = std::max(founder.score.peakEnergy, tree.energy);
+					for (auto* cells : {&tree.aliveCells, &tree.deadCells})
+						for (auto& pos : *cells)
+							founder.score.height = std::max(founder.score.height, pos.y + 1);
+				}
+			}
+			world.events = nullptr;
+
+			std::vector<Score> scores;
+			for (auto& founder : founders)
+				scores.push_back(founder.score);
+			return scores;
+		}
+	}
+
+	std::vector<Fitness> evaluate_genomes(const FitnessOptions& options)
+	{
+		if (options.group < 1 || options.trials < 1 || options.spacing == 0)
+			throw std::invalid_argument("Group, trials and spacing of genom evaluation must be positive");
+		const unsigned int baseSeed = options.params.seed ? options.params.seed : std::random_device{}();
+		game::Random random;
+		random.seed(baseSeed);
+		std::vector<game::Genom> genomes = options.genomes;
+		if (genomes.empty())
+			for (int i = 0; i < options.candidates; i++)
+				genomes.emplace_back(random);
+
+		/* every trial shuffles genomes into new groups, so they meet different neighbours */
+		const std::size_t group = std::min<std::size_t>(options.group, genomes.size());
+		std::vector<std::vector<std::size_t>> groups;
+		std::vector<std::size_t> order(genomes.size());
+		std::iota(order.begin(), order.end(), 0);
+		for (int trial = 0; trial < options.trials; trial++)
+		{
+			if (group > 1)
+				std::shuffle(order.begin(), order.end(), random.engine());
+			for (std::size_t first = 0; first < order.size(); first += group)
+				groups.emplace_back(order.begin() + first, order.begin() + std::min(first + group, order.size()));
+		}
+
+		using clock = std::chrono::steady_clock;
+		const auto start = clock::now();
+		register_components();
+		std::vector<std::vector<Score>> scores(groups.size());
+		run_jobs(groups.size(), options.jobs, [&](std::size_t job) {
+			const unsigned int seed = baseSeed + 1 + static_cast<unsigned int>(job);
+			scores[job] = run_group(options, genomes, groups[job], seed ? seed : 1u); /* 0 would mean random seed */
+		});
+
+		std::vector<Fitness> ranking(genomes.size());
+		for (std::size_t i = 0; i < genomes.size(); i++)
+			ranking[i].genom = genomes[i];
+		for (std::size_t job = 0; job < groups.size(); job++)
+			for (std::size_t i = 0; i < groups[job].size(); i++)
+			{
+				auto& fitness = ranking[groups[job][i]];
+				auto& score = scores[job][i];
+				fitness.seeds += score.seeds;
+				fitness.peakEnergy += score.peakEnergy;
+				fitness.height += score.height;
+				fitness.starved += score.starved;
+			}
+		for (auto& fitness : ranking)
+			for (double* value : {&fitness.seeds, &fitness.peakEnergy, &fitness.height, &fitness.starved})
+				*value /= options.trials;
+		std::stable_sort(ranking.begin(), ranking.end(), [](const Fitness& a, const Fitness& b) {
+			if (a.seeds != b.seeds)
+				return a.seeds > b.seeds;
+			if (a.peakEnergy != b.peakEnergy)
+				return a.peakEnergy > b.peakEnergy;
+			return a.height > b.height;
+		});
+		fmt::print(stderr, "Evaluated {} genomes in {} worlds in {:.2f}s with seed {}.\n", genomes.size(), groups.size(),
+				   std::chrono::duration<double>(clock::now() - start).count(), baseSeed);
+
+		if (!options.outPath.empty())
+		{
+			nlohmann::json j = nlohmann::json::array();
+			for (auto& fitness : ranking)
+				j.push_back({{"seeds", fitness.seeds},
+							 {"peak_energy", fitness.peakEnergy},
+							 {"height", fitness.height},
+							 {"starved", fitness.starved},
+							 {"genom", fitness.genom}});
+			std::FILE* out = std::fopen(options.outPath.c_str(), "w");
+			if (!out)
+				throw std::runtime_error("Can't open " + options.outPath);
+			fmt::print(out, "{}\n", j.dump(2));
+			std::fclose(out);
+		}
+
+		fmt::print("rank,seeds,peak_energy,height,starved,genom\n");
+		for (std::size_t i = 0; i < ranking.size(); i++)
+		{
+			auto& fitness = ranking[i];
+			fmt::print("{},{:.1f},{:.1f},{:.1f},{:.2f},{:016x}\n", i + 1, fitness.seeds, fitness.peakEnergy,
+					   fitness.height, fitness.starved, fitness.genom.hash());
+		}
+		return ranking;
+	}
+}
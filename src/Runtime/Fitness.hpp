@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Game/World.hpp"
+
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+	struct FitnessOptions
+	{
+		/* width of a mini world per planted tree and its height */
+		unsigned int spacing = 20;
+		unsigned int h = 50;
+		/* parameters of all mini worlds, seed is the seed of first one and of random genomes */
+		game::Parameters params;
+		/* genomes to evaluate, random ones are generated when it's empty */
+		std::vector<game::Genom> genomes;
+		/* number of random genomes */
+		int candidates = 64;
+		/* number of trees planted together in a mini world */
+		int group = 1;
+		/* number of mini worlds every genom is planted in */
+		int trials = 3;
+		/* number of worker threads, 0 means one per core */
+		unsigned int jobs = 0;
+		/* file to write ranked genomes to in json format */
+		std::string outPath;
+	};
+
+	/**
+	 * @brief How well a genom did, averaged over its trials.
+	 */
+	struct Fitness
+	{
+		game::Genom genom;
+		/* seeds it turned into when it died of old age */
+		double seeds = 0.0;
+		double peakEnergy = 0.0;
+		/* height of its highest cell */
+		double height = 0.0;
+		/* share of trials it ran out of energy in */
+		double starved = 0.0;
+	};
+
+	/**
+	 * @brief Plant genomes in small isolated worlds on a pool of threads and
+	 * rank them.
+	 * @detail Every trial shuffles genomes into groups of options.group
+	 * trees, each group is planted with Tree::spawn in its own world which
+	 * ticks until all of them die, at most Parameters::maxMaxAge years.
+	 * Genomes are ranked by seeds, then by peak energy, then by height. The
+	 * ranking is written to options.outPath, game::load_genomes() reads it
+	 * back, and printed to stdout in csv format.
+	 * @return genomes from the best one
+	 * @throw std::invalid_argument if group, trials or spacing isn't positive
+	 * @throw std::runtime_error if options.outPath can't be written
+	 */
+	std::vector<Fitness> evaluate_genomes(const FitnessOptions& options);
+}
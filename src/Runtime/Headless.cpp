@@ -0,0 +1,166 @@
+#include "Headless.hpp"
+#include "Metrics.hpp"
+#include "Recording.hpp"
+#include "SharedFrames.hpp"
+#include "Game/Memory.hpp"
+#include "Game/Serialization.hpp"
+#include "Game/Statistics.hpp"
+#include "Game/World.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <stdexcept>
+#include <fmt/core.h>
+
+namespace runtime
+{
+	static volatile std::sig_atomic_t interrupted = 0;
+
+	static void on_interrupt(int)
+	{
+		interrupted = 1;
+	}
+
+	static void print_statistics(std::FILE* out, int tick, const game::World& world)
+	{
+		auto stats = game::gather_statistics(world);
+		fmt::print(out, "{},{},{},{},{},{:016x}\n", tick, stats.trees, stats.seeds, stats.cells, stats.energy,
+				   world.hash);
+	}
+
+	static void print_profile(std::FILE* out, int tick, const game::TickProfile& profile)
+	{
+		using game::TickProfile;
+		auto us = [&](TickProfile::Phase phase) {
+			return std::chrono::duration<double, std::micro>(profile.time[phase]).count();
+		};
+		fmt::print(out, "{},{:.1f},{:.1f},{:.1f},{},{},{},{},{},{},{},{},{}\n", tick,
+				   us(TickProfile::PHYSICS), us(TickProfile::GROW), us(TickProfile::SUN),
+				   profile.entities[TickProfile::PHYSICS], profile.entities[TickProfile::GROW],
+				   profile.entities[TickProfile::SUN], profile.cellsGrown, profile.seedsSpawned,
+				   profile.seedsDestroyed, profile.seedsPlanted, profile.nodesAllocated, profile.nodesFreed);
+	}
+
+	static void print_memory(std::FILE* out, int tick, const game::World& world)
+	{
+		auto report = game::memory_report(world);
+		fmt::print(out, "{}", tick);
+		for (auto& pool : report.pools)
+			fmt::print(out, ",{},{}", pool.liveBytes, pool.reservedBytes);
+		fmt::print(out, ",{},{},{},{},{},{},{},{},{}\n", report.entityBytes, report.fieldBytes,
+				   report.listNodes, report.listNodeBytes, report.listPoolBytes, report.genomBytes,
+				   report.total(), report.rss, report.peakRss);
+	}
+
+	int run_headless(game::World& world, const HeadlessOptions& options)
+	{
+		if (!options.profilePath.empty() && !game::profiling_enabled)
+			throw std::runtime_error("Tick profiling needs a build with CURSED_TREES_PROFILE enabled");
+		std::FILE* out = stdout;
+		if (!options.csvPath.empty())
+		{
+			out = std::fopen(options.csvPath.c_str(), "w");
+			if (!out)
+				throw std::runtime_error("Can't open " + options.csvPath);
+		}
+		std::FILE* profileOut = nullptr;
+		if (!options.profilePath.empty())
+		{
+			profileOut = std::fopen(options.profilePath.c_str(), "w");
+			if (!profileOut)
+			{
+				if (out != stdout)
+					std::fclose(out);
+				throw std::runtime_error("Can't open " + options.profilePath);
+			}
+			fmt::print(profileOut, "tick,physics_us,grow_us,sun_us,seeds_falling,trees_growing,cells_lit,"
+					   "cells_grown,seeds_spawned,seeds_destroyed,seeds_planted,nodes_allocated,nodes_freed\n");
+		}
+		std::FILE* memoryOut = nullptr;
+		if (!options.memoryPath.empty())
+		{
+			memoryOut = std::fopen(options.memoryPath.c_str(), "w");
+			if (!memoryOut)
+			{
+				if (profileOut)
+					std::fclose(profileOut);
+				if (out != stdout)
+					std::fclose(out);
+				throw std::runtime_error("Can't open " + options.memoryPath);
+			}
+			fmt::print(memoryOut, "tick");
+			for (auto& pool : game::memory_report(world).pools)
+				fmt::print(memoryOut, ",{0}_bytes,{0}_reserved_bytes", pool.name);
+			fmt::print(memoryOut, ",entity_bytes,field_bytes,list_nodes,list_node_bytes,list_pool_bytes,"
+					   "genom_bytes,total_bytes,rss,peak_rss\n");
+			print_memory(memoryOut, 0, world);
+		}
+		auto dumpAt = options.dumpAt;
+		std::sort(dumpAt.begin(), dumpAt.end());
+		auto nextDump = dumpAt.begin();
+
+		interrupted = 0;
+		auto prevInt = std::signal(SIGINT, on_interrupt);
+		auto prevTerm = std::signal(SIGTERM, on_interrupt);
+
+		using clock = std::chrono::steady_clock;
+		const auto start = clock::now();
+		fmt::print(out, "tick,trees,seeds,cells,energy,hash\n");
+		print_statistics(out, 0, world);
+		if (options.publisher)
+			options.publisher->publish(world, 0);
+		int tick = 0;
+		bool alive = true;
+		const int ticks = options.replay ? static_cast<int>(options.replay->ticks()) : options.ticks;
+		while (alive && !interrupted && ((ticks == 0 && !options.replay) || tick < ticks))
+		{
+			if (options.replay)
+				options.replay->apply(world, tick);
+			alive = world.tick();
+			tick++;
+			if (options.publisher)
+				options.publisher->update(world, tick);
+			if (options.metrics)
+				options.metrics->update(world);
+			if (profileOut)
+				print_profile(profileOut, tick, world.profile);
+			if (tick % options.statsEvery == 0)
+			{
+				print_statistics(out, tick, world);
+				if (memoryOut)
+					print_memory(memoryOut, tick, world);
+			}
+			for (; nextDump != dumpAt.end() && *nextDump <= tick; ++nextDump)
+				if (*nextDump == tick)
+					game::dump_json(world, fmt::format("dump-{}.json", tick));
+		}
+		if (tick % options.statsEvery != 0)
+		{
+			print_statistics(out, tick, world);
+			if (memoryOut)
+				print_memory(memoryOut, tick, world);
+		}
+
+		if (options.publisher)
+			options.publisher->publish(world, tick);
+
+		std::signal(SIGINT, prevInt);
+		std::signal(SIGTERM, prevTerm);
+		if (profileOut)
+			std::fclose(profileOut);
+		if (memoryOut)
+			std::fclose(memoryOut);
+		if (out != stdout)
+			std::fclose(out);
+		else
+			std::fflush(out);
+
+		const std::chrono::duration<double> elapsed = clock::now() - start;
+		fmt::print(stderr, "Simulated {} ticks in {:.2f}s ({:.0f} ticks/s) with seed {}{}, final hash {:016x}.\n",
+				   tick, elapsed.count(), tick / std::max(elapsed.count(), 1e-9), world.params.seed,
+				   alive ? "" : ", all trees died", world.hash);
+		return tick;
+	}
+}
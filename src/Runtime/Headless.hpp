@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace game
+{
+	class World;
+}
+
+namespace runtime
+{
+	class FramePublisher;
+	class MetricsServer;
+	class Replay;
+
+	struct HeadlessOptions
+	{
+		/* number of ticks to simulate, 0 means until extinction */
+		int ticks = 0;
+		/* print statistics every n ticks */
+		int statsEvery = 100;
+		/* file to write statistics to in csv format, stdout if empty */
+		std::string csvPath;
+		/* ticks at which world is dumped to dump-<tick>.json */
+		std::vector<int> dumpAt;
+		/* file to write tick profile of every tick to, needs CURSED_TREES_PROFILE build */
+		std::string profilePath;
+		/* file to write memory report to in csv format every statsEvery ticks */
+		std::string memoryPath;
+		/* inputs of a recorded run to apply, then ticks is ignored and the recorded number of ticks is simulated */
+		Replay* replay = nullptr;
+		/* publishes frames for detached viewers when set */
+		FramePublisher* publisher = nullptr;
+		/* serves metrics over HTTP when set */
+		MetricsServer* metrics = nullptr;
+	};
+
+	/**
+	 * @brief Run simulation without terminal as fast as possible.
+	 * @detail Stops after @a options.ticks ticks, when all trees die or on
+	 * SIGINT/SIGTERM. Doesn't touch curses at all.
+	 * @return number of simulated ticks.
+	 * @throw std::runtime_error if csv, profile or memory file can't be opened
+	 */
+	int run_headless(game::World& world, const HeadlessOptions& options);
+}
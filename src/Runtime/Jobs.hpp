@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Game/Components.hpp"
+#include "Game/Tree.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <entt/entity/registry.hpp>
+
+namespace runtime
+{
+	/**
+	 * @brief Make EnTT assign ids to component types, call before worlds
+	 * are created on several threads.
+	 * @detail EnTT assigns them on first use, which isn't thread safe.
+	 */
+	inline void register_components()
+	{
+		entt::registry registry;
+		registry.reserve<game::Tree>(0);
+		registry.reserve<game::Living>(0);
+		registry.reserve<game::Falling>(0);
+		registry.reserve<game::Cell>(0);
+	}
+
+	/**
+	 * @brief Call @a job with every index in [0, count) on a pool of threads.
+	 * @detail Indices are handed out one by one in increasing order. The
+	 * first exception stops handing them out and is rethrown when every
+	 * thread has finished.
+	 * @param jobs number of threads, 0 means one per core
+	 */
+	template<typename F>
+	void run_jobs(std::size_t count, unsigned int jobs, F&& job)
+	{
+		std::atomic<std::size_t> next{0};
+		std::mutex mutex;
+		std::exception_ptr error;
+		auto worker = [&]() {
+			for (std::size_t i; (i = next++) < count;)
+			{
+				try
+				{
+					job(i);
+				}
+				catch (...)
+				{
+					std::lock_guard lock(mutex);
+					if (!error)
+						error = std::current_exception();
+					next = count; /* stop other workers */
+				}
+			}
+		};
+		if (jobs == 0)
+			jobs = std::max(std::thread::hardware_concurrency(), 1u);
+		std::vector<std::thread> workers;
+		for (unsigned int i = 0; i < std::min<std::size_t>(jobs, count); i++)
+			workers.emplace_back(worker);
+		for (auto& thread : workers)
+			thread.join();
+		if (error)
+			std::rethrow_exception(error);
+	}
+}
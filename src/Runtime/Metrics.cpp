@@ -0,0 +1,335 @@
+#include "Metrics.hpp"
+#include "Game/Memory.hpp"
+#include "Game/Serialization.hpp"
+#include "Game/Statistics.hpp"
+#include "Game/Trace.hpp"
+#include "Game/World.hpp"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <arpa/inet.h>
+#include <entt/entity/registry.hpp>
+#include <fmt/format.h>
+#include <netinet/in.h>
+#include <nlohmann/json.hpp>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace runtime
+{
+	using namespace std::chrono_literals;
+
+	/* how long a tree request waits for the world's thread */
+	constexpr auto tree_timeout = 2s;
+	/* /tree clients waiting at once, more are turned away */
+	constexpr std::size_t max_tree_clients = 16;
+	/* memory_report() walks all trees, so memory is measured once in this many publishes */
+	constexpr unsigned int memory_period = 10;
+
+	static const char* status_text(int status)
+	{
+		switch (status)
+		{
+		case 200: return "OK";
+		case 400: return "Bad Request";
+		case 404: return "Not Found";
+		case 405: return "Method Not Allowed";
+		case 503: return "Service Unavailable";
+		default: return "Internal Server Error";
+		}
+	}
+
+	static std::string error_json(std::string_view message)
+	{
+		return nlohmann::json{{"error", message}}.dump();
+	}
+
+	static void send_response(int client, const std::pair<int, std::string>& response, const char* type)
+	{
+		auto reply = fmt::format("HTTP/1.0 {} {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n",
+								 response.first, status_text(response.first), type, response.second.size());
+		reply += response.second;
+		for (std::size_t sent = 0; sent < reply.size();)
+		{
+			auto n = ::send(client, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+			if (n <= 0)
+				return;
+			sent += n;
+		}
+	}
+
+	/* value of key in "a=1&b=2", false if it is missing or not a number */
+	static bool query_value(std::string_view query, std::string_view key, std::uint32_t& value)
+	{
+		while (!query.empty())
+		{
+			auto amp = query.find('&');
+			auto pair = query.substr(0, amp);
+			auto eq = pair.find('=');
+			if (eq != std::string_view::npos && pair.substr(0, eq) == key)
+			{
+				auto number = pair.substr(eq + 1);
+				auto [end, error] = std::from_chars(number.data(), number.data() + number.size(), value);
+				return error == std::errc{} && end == number.data() + number.size();
+			}
+			if (amp == std::string_view::npos)
+				break;
+			query.remove_prefix(amp + 1);
+		}
+		return false;
+	}
+
+	MetricsServer::MetricsServer(unsigned short port, std::chrono::steady_clock::duration interval)
+		: interval(interval), published(std::make_shared<const Metrics>())
+	{
+		listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (listener < 0)
+			throw std::runtime_error(std::string("Can't create socket: ") + std::strerror(errno));
+		int yes = 1;
+		::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(listener, 16) < 0)
+		{
+			auto error = std::runtime_error("Can't listen on 127.0.0.1:" + std::to_string(port) + ": " + std::strerror(errno));
+			::close(listener);
+			throw error;
+		}
+		thread = std::thread(&MetricsServer::run, this);
+		treeThread = std::thread(&MetricsServer::answerTrees, this);
+	}
+
+	MetricsServer::~MetricsServer()
+	{
+		quit.signal();
+		thread.join();
+		::close(listener);
+		{
+			/* nobody will answer requests which are left */
+			std::lock_guard lock(mutex);
+			stopped = true;
+			for (auto& request : requests)
+				request->response.set_value({503, error_json("server stopped")});
+			requests.clear();
+		}
+		{
+			std::lock_guard lock(clientsMutex);
+			stopping = true;
+		}
+		clientsChanged.notify_one();
+		treeThread.join();
+	}
+
+	void MetricsServer::onRequest(std::function<void()> wake)
+	{
+		std::lock_guard lock(mutex);
+		this->wake = std::move(wake);
+	}
+
+	void MetricsServer::update(game::World& world)
+	{
+		std::vector<std::unique_ptr<TreeRequest>> todo;
+		{
+			std::unique_lock lock(mutex, std::try_to_lock);
+			if (lock.owns_lock())
+				todo.swap(requests);
+		}
+		for (auto& request : todo)
+		{
+			entt::entity entity = entt::null;
+			if (request->byId)
+				entity = static_cast<entt::entity>(request->id);
+			else if (request->x < world.w && request->y < world.h)
+				if (auto pCell = world.registry.try_get<game::Cell>(world.at({request->x, request->y})))
+					entity = pCell->parent;
+			if (entity != entt::null && world.registry.valid(entity) && world.registry.all_of<game::Tree>(entity))
+				request->response.set_value({200, game::serialize_tree(world, entity).dump()});
+			else
+				request->response.set_value({404, error_json("no such tree")});
+		}
+
+		const auto now = Metrics::clock::now();
+		if (now < next)
+			return;
+		next = now + interval;
+		CURSED_TREES_TRACE("MetricsServer::update");
+		auto previous = published.load(std::memory_order_acquire);
+		auto metrics = std::make_shared<Metrics>();
+		const auto stats = game::gather_statistics(world);
+		metrics->time = now;
+		metrics->ticks = world.year;
+		if (previous->time != Metrics::clock::time_point{})
+		{
+			metrics->period = now - previous->time;
+			metrics->ticksPerSecond = double(metrics->ticks - previous->ticks) /
+				std::chrono::duration<double>(metrics->period).count();
+		}
+		metrics->trees = stats.trees;
+		metrics->living = stats.living();
+		metrics->seeds = stats.seeds;
+		metrics->cells = stats.cells;
+		metrics->species = stats.species;
+		metrics->energy = stats.energy;
+		metrics->minSun = world.params.minSun;
+		metrics->profile = world.profile;
+		if (publishes++ % memory_period == 0)
+		{
+			const auto memory = game::memory_report(world);
+			metrics->memoryBytes = memory.total();
+			metrics->rss = memory.rss;
+		}
+		else
+		{
+			metrics->memoryBytes = previous->memoryBytes;
+			metrics->rss = previous->rss;
+		}
+		published.store(std::move(metrics), std::memory_order_release);
+	}
+
+	void MetricsServer::run()
+	{
+		game::trace::name_thread("metrics");
+		while (!(wait({quit.handle(), listener}) & 1))
+		{
+			int client = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+			if (client < 0)
+				continue;
+			/* one client at a time, a slow one can't hold the server for long */
+			timeval timeout{1, 0};
+			::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+			::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+			if (serve(client))
+				::close(client);
+		}
+	}
+
+	bool MetricsServer::serve(int client)
+	{
+		std::string request;
+		char buffer[1024];
+		while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+		{
+			auto n = ::recv(client, buffer, sizeof(buffer), 0);
+			if (n <= 0)
+				return true;
+			request.append(buffer, n);
+		}
+		std::pair<int, std::string> response;
+		const char* type = "application/json";
+		std::string_view line{request.data(), request.find("\r\n")};
+		auto space = line.find(' '), space2 = line.rfind(' ');
+		if (space == std::string_view::npos || space2 <= space)
+			response = {400, error_json("bad request")};
+		else if (line.substr(0, space) != "GET")
+			response = {405, error_json("only GET is supported")};
+		else
+		{
+			auto target = line.substr(space + 1, space2 - space - 1);
+			auto question = target.find('?');
+			auto path = target.substr(0, question);
+			auto query = question == std::string_view::npos ? std::string_view{} : target.substr(question + 1);
+			if (path == "/metrics")
+			{
+				response = metrics();
+				type = "text/plain; version=0.0.4";
+			}
+			else if (path == "/tree")
+			{
+				std::lock_guard lock(clientsMutex);
+				if (treeClients.size() < max_tree_clients)
+				{
+					treeClients.push_back({client, std::string(query)});
+					clientsChanged.notify_one();
+					return false;
+				}
+				response = {503, error_json("too many tree requests")};
+			}
+			else
+				response = {404, error_json("try /metrics or /tree?x=X&y=Y")};
+		}
+		send_response(client, response, type);
+		return true;
+	}
+
+	void MetricsServer::answerTrees()
+	{
+		game::trace::name_thread("metrics trees");
+		std::unique_lock lock(clientsMutex);
+		while (true)
+		{
+			clientsChanged.wait(lock, [this] { return stopping || !treeClients.empty(); });
+			if (treeClients.empty())
+				return;
+			auto client = std::move(treeClients.front());
+			treeClients.pop_front();
+			lock.unlock();
+			send_response(client.socket, tree(client.query), "application/json");
+			::close(client.socket);
+			lock.lock();
+		}
+	}
+
+	std::pair<int, std::string> MetricsServer::metrics() const
+	{
+		const auto metrics = published.load(std::memory_order_acquire);
+		/* a world which stopped publishing isn't ticking, e.g. it's paused */
+		const auto age = Metrics::clock::now() - metrics->time;
+		const double ticksPerSecond = age > 2 * metrics->period + interval ? 0.0 : metrics->ticksPerSecond;
+		std::string text;
+		auto out = std::back_inserter(text);
+		auto gauge = [&](const char* name, const char* help, auto value) {
+			fmt::format_to(out, "# HELP cursed_trees_{0} {1}\n# TYPE cursed_trees_{0} gauge\ncursed_trees_{0} {2}\n",
+						   name, help, value);
+		};
+		fmt::format_to(out, "# HELP cursed_trees_ticks_total Ticks simulated.\n# TYPE cursed_trees_ticks_total counter\n"
+					   "cursed_trees_ticks_total {}\n", metrics->ticks);
+		gauge("ticks_per_second", "Ticks simulated per second since the previous update.", ticksPerSecond);
+		gauge("trees", "Trees including falling seeds.", metrics->trees);
+		gauge("living_trees", "Trees which are planted.", metrics->living);
+		gauge("falling_seeds", "Seeds which haven't landed yet.", metrics->seeds);
+		gauge("cells", "Cells of all trees.", metrics->cells);
+		gauge("species", "Distinct genoms among living trees.", metrics->species);
+		gauge("energy", "Energy of all trees.", metrics->energy);
+		gauge("min_sun", "Energy sun gives to cells in addition to their height.", metrics->minSun);
+		gauge("memory_bytes", "Bytes reserved by the world's registry, field and cell lists.", metrics->memoryBytes);
+		gauge("resident_memory_bytes", "Resident set size of the process.", metrics->rss);
+		/* phases are timed only in builds with the tick profiler */
+		if (game::profiling_enabled)
+		{
+			constexpr const char* phases[] = {"physics", "grow", "sun"};
+			text += "# HELP cursed_trees_phase_seconds Time the last tick spent in a phase.\n"
+				"# TYPE cursed_trees_phase_seconds gauge\n";
+			for (int phase = 0; phase < game::TickProfile::NUM_PHASES; phase++)
+				fmt::format_to(out, "cursed_trees_phase_seconds{{phase=\"{}\"}} {}\n", phases[phase],
+							   std::chrono::duration<double>(metrics->profile.time[phase]).count());
+		}
+		return {200, std::move(text)};
+	}
+
+	std::pair<int, std::string> MetricsServer::tree(const std::string& query)
+	{
+		auto request = std::make_unique<TreeRequest>();
+		request->byId = query_value(query, "id", request->id);
+		if (!request->byId && !(query_value(query, "x", request->x) && query_value(query, "y", request->y)))
+			return {400, error_json("tree needs x and y or id")};
+		auto response = request->response.get_future();
+		std::function<void()> wakeWorld;
+		{
+			std::lock_guard lock(mutex);
+			if (stopped)
+				return {503, error_json("server stopped")};
+			requests.push_back(std::move(request));
+			wakeWorld = wake;
+		}
+		if (wakeWorld)
+			wakeWorld();
+		if (response.wait_for(tree_timeout) != std::future_status::ready)
+			return {503, error_json("simulation didn't answer in time")};
+		return response.get();
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Events.hpp"
+#include "Game/Profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace game
+{
+	class World;
+}
+
+namespace runtime
+{
+	/**
+	 * @brief Numbers MetricsServer serves, published by the world's thread.
+	 */
+	struct Metrics
+	{
+		using clock = std::chrono::steady_clock;
+
+		/* when and how long after the previous one it was published */
+		clock::time_point time;
+		clock::duration period{};
+		std::uint64_t ticks = 0;
+		double ticksPerSecond = 0;
+		std::size_t trees = 0, living = 0, seeds = 0, cells = 0, species = 0;
+		long long energy = 0;
+		int minSun = 0;
+		game::TickProfile profile;
+		/* see game::MemoryReport */
+		std::size_t memoryBytes = 0, rss = 0;
+	};
+
+	/**
+	 * @brief Serves metrics of a world over HTTP on 127.0.0.1 from its own thread.
+	 * @detail GET /metrics returns Prometheus text format, GET /tree?x=X&y=Y
+	 * or /tree?id=ENTITY returns game::serialize_tree() of the tree growing
+	 * at a tile or of an entity. Metrics are read from a snapshot which the
+	 * world's thread swaps in with update(), so scrapes never lock ticks.
+	 * Trees can only be serialized on the world's thread, such requests are
+	 * queued and answered by the next update(). Their clients wait for the
+	 * answer on a thread of their own, so they never hold up /metrics.
+	 */
+	class MetricsServer
+	{
+	public:
+		/**
+		 * @param interval publish metrics at most once per interval
+		 * @throw std::runtime_error if @a port can't be listened on
+		 */
+		explicit MetricsServer(unsigned short port,
+							   std::chrono::steady_clock::duration interval = std::chrono::seconds{1});
+		~MetricsServer();
+
+		MetricsServer(const MetricsServer&) = delete;
+		MetricsServer& operator=(const MetricsServer&) = delete;
+
+		/**
+		 * @brief Publish metrics of @a world if interval passed and answer
+		 * queued tree requests. Call from the world's thread after ticks,
+		 * it never waits for the server thread.
+		 */
+		void update(game::World& world);
+		/**
+		 * @brief Called from the server thread when a tree request is queued,
+		 * so that a world which isn't ticking can call update().
+		 */
+		void onRequest(std::function<void()> wake);
+
+	private:
+		struct TreeRequest
+		{
+			/* tile unless byId is set */
+			unsigned int x = 0, y = 0;
+			bool byId = false;
+			std::uint32_t id = 0;
+			/* http status and body */
+			std::promise<std::pair<int, std::string>> response;
+		};
+
+		struct TreeClient
+		{
+			int socket;
+			std::string query;
+		};
+
+		void run();
+		/* false if the client was handed to the tree thread, which closes it */
+		bool serve(int client);
+		void answerTrees();
+		std::pair<int, std::string> metrics() const;
+		std::pair<int, std::string> tree(const std::string& query);
+
+		int listener = -1;
+		std::chrono::steady_clock::duration interval;
+		EventFd quit;
+		std::thread thread;
+		std::atomic<std::shared_ptr<const Metrics>> published;
+
+		/* guarded by mutex, world's thread only tries to lock it */
+		std::mutex mutex;
+		std::vector<std::unique_ptr<TreeRequest>> requests;
+		std::function<void()> wake;
+		bool stopped = false;
+
+		/* /tree clients waiting for the world's thread, guarded by clientsMutex */
+		std::mutex clientsMutex;
+		std::condition_variable clientsChanged;
+		std::deque<TreeClient> treeClients;
+		bool stopping = false;
+		std::thread treeThread;
+
+		/* owned by world's thread */
+		Metrics::clock::time_point next;
+		unsigned int publishes = 0;
+	};
+}
@@ -0,0 +1,162 @@
+#include "Recording.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace runtime
+{
+	constexpr char magic[4] = {'C', 'T', 'R', 'R'};
+	constexpr std::uint32_t version = 1;
+
+	static void put_u32(std::FILE* file, std::uint32_t value)
+	{
+		unsigned char bytes[4];
+		for (int i = 0; i < 4; i++)
+			bytes[i] = static_cast<unsigned char>(value >> (i * 8));
+		std::fwrite(bytes, 1, 4, file);
+	}
+
+	static void put_i32(std::FILE* file, std::int32_t value)
+	{
+		put_u32(file, static_cast<std::uint32_t>(value));
+	}
+
+	static std::uint32_t get_u32(std::FILE* file)
+	{
+		unsigned char bytes[4];
+		if (std::fread(bytes, 1, 4, file) != 4)
+			throw std::runtime_error("Recording is truncated");
+		std::uint32_t value = 0;
+		for (int i = 0; i < 4; i++)
+			value |= std::uint32_t(bytes[i]) << (i * 8);
+		return value;
+	}
+
+	static std::int32_t get_i32(std::FILE* file)
+	{
+		return static_cast<std::int32_t>(get_u32(file));
+	}
+
+	Recorder::Recorder(const std::string& filename, const game::World& world,
+					   const std::vector<RecordedSpawn>& spawns)
+		: file(std::fopen(filename.c_str(), "wb")), start(std::chrono::steady_clock::now())
+	{
+		if (!file)
+			throw std::runtime_error("Can't open " + filename);
+		std::fwrite(magic, 1, sizeof(magic), file);
+		put_u32(file, version);
+		put_u32(file, world.w);
+		put_u32(file, world.h);
+		const auto& params = world.params;
+		std::uint32_t mutationChance;
+		std::memcpy(&mutationChance, &params.mutationChance, sizeof(mutationChance));
+		put_i32(file, params.minSun);
+		put_u32(file, params.sunLevels);
+		put_i32(file, params.upkeep);
+		put_i32(file, params.energyScale);
+		put_u32(file, mutationChance);
+		put_i32(file, params.minMaxAge);
+		put_i32(file, params.maxMaxAge);
+		put_u32(file, params.seed);
+		put_u32(file, static_cast<std::uint32_t>(spawns.size()));
+		for (auto& spawn : spawns)
+		{
+			put_u32(file, spawn.x);
+			put_i32(file, spawn.energy);
+		}
+	}
+
+	Recorder::~Recorder()
+	{
+		std::fclose(file);
+	}
+
+	void Recorder::record(std::uint32_t tick, RecordedEvent::Type type, std::int32_t value)
+	{
+		if (ended)
+			return;
+		auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+		put_u32(file, tick);
+		std::fputc(static_cast<int>(type), file);
+		put_i32(file, value);
+		put_u32(file, static_cast<std::uint32_t>(millis.count()));
+		ended = type == RecordedEvent::Type::END;
+		/* inputs are rare, keep them on disk in case the program crashes */
+		std::fflush(file);
+	}
+
+	Replay::Replay(const std::string& filename)
+	{
+		std::FILE* file = std::fopen(filename.c_str(), "rb");
+		if (!file)
+			throw std::runtime_error("Can't open " + filename);
+		try
+		{
+			char header[4];
+			if (std::fread(header, 1, 4, file) != 4 || std::memcmp(header, magic, 4) != 0)
+				throw std::runtime_error(filename + " is not a recording");
+			if (get_u32(file) != version)
+				throw std::runtime_error(filename + " was recorded by another version");
+			w = get_u32(file);
+			h = get_u32(file);
+			params.minSun = get_i32(file);
+			params.sunLevels = get_u32(file);
+			params.upkeep = get_i32(file);
+			params.energyScale = get_i32(file);
+			std::uint32_t mutationChance = get_u32(file);
+			std::memcpy(&params.mutationChance, &mutationChance, sizeof(mutationChance));
+			params.minMaxAge = get_i32(file);
+			params.maxMaxAge = get_i32(file);
+			params.seed = get_u32(file);
+			spawns.resize(get_u32(file));
+			for (auto& spawn : spawns)
+			{
+				spawn.x = get_u32(file);
+				spawn.energy = get_i32(file);
+			}
+			/* a recording without END (e.g. the program crashed) ends at its last event */
+			int type;
+			while ((type = std::fgetc(file)) != EOF)
+			{
+				std::ungetc(type, file);
+				RecordedEvent event;
+				event.tick = get_u32(file);
+				type = std::fgetc(file);
+				if (type == EOF || type > static_cast<int>(RecordedEvent::Type::MUTATION_CHANCE))
+					throw std::runtime_error(filename + " has a corrupted event");
+				event.type = static_cast<RecordedEvent::Type>(type);
+				event.value = get_i32(file);
+				event.millis = get_u32(file);
+				events.push_back(event);
+				if (event.type == RecordedEvent::Type::END)
+					break;
+			}
+		}
+		catch (...)
+		{
+			std::fclose(file);
+			throw;
+		}
+		std::fclose(file);
+	}
+
+	void Replay::populate(game::World& world) const
+	{
+		for (auto& spawn : spawns)
+			game::Tree::spawn(world, spawn.x, spawn.energy);
+	}
+
+	void Replay::apply(game::World& world, std::uint32_t tick)
+	{
+		for (; next < events.size() && events[next].tick <= tick; next++)
+			if (events[next].type == RecordedEvent::Type::MIN_SUN)
+				world.params.minSun = events[next].value;
+			else if (events[next].type == RecordedEvent::Type::MUTATION_CHANCE)
+				std::memcpy(&world.params.mutationChance, &events[next].value, sizeof(float));
+	}
+
+	std::uint32_t Replay::ticks() const
+	{
+		return events.empty() ? 0 : events.back().tick;
+	}
+}
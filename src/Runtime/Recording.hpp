@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Game/World.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+	/**
+	 * @brief Input which happened at some tick of a recorded run.
+	 */
+	struct RecordedEvent
+	{
+		enum class Type : std::uint8_t
+		{
+			/* world.params.minSun = value */
+			MIN_SUN,
+			/* simulation paused (value = 1) or resumed (value = 0), informational */
+			PAUSE,
+			/* fast forward of value ticks requested, informational */
+			SKIP,
+			/* fast forward cancelled, informational */
+			CANCEL,
+			/* run ended, the last event of a recording */
+			END,
+			/* world.params.mutationChance = value's bits as float, after END so older recordings stay valid */
+			MUTATION_CHANCE
+		};
+
+		/* number of ticks simulated before the event took effect */
+		std::uint32_t tick = 0;
+		Type type = Type::END;
+		std::int32_t value = 0;
+		/* milliseconds since recording started */
+		std::uint32_t millis = 0;
+	};
+
+	/* initial tree, see game::Tree::spawn */
+	struct RecordedSpawn
+	{
+		std::uint32_t x = 0;
+		std::int32_t energy = 300;
+	};
+
+	/**
+	 * @brief Writes world's seed, parameters, initial trees and inputs to a
+	 * binary log which Replay reproduces the run from.
+	 * @detail Format, little endian: "CTRR", u32 version, u32 w, u32 h,
+	 * parameters, u32 number of spawns, spawns (u32 x, i32 energy), then
+	 * events (u32 tick, u8 type, i32 value, u32 millis) until END.
+	 * Only the simulation thread may record events.
+	 */
+	class Recorder
+	{
+	public:
+		/**
+		 * @throw std::runtime_error if @a filename can't be opened.
+		 */
+		Recorder(const std::string& filename, const game::World& world, const std::vector<RecordedSpawn>& spawns);
+		~Recorder();
+
+		Recorder(const Recorder&) = delete;
+		Recorder& operator=(const Recorder&) = delete;
+
+		void record(std::uint32_t tick, RecordedEvent::Type type, std::int32_t value = 0);
+
+	private:
+		std::FILE* file;
+		std::chrono::steady_clock::time_point start;
+		bool ended = false;
+	};
+
+	/**
+	 * @brief Recorded run loaded back from file.
+	 */
+	class Replay
+	{
+	public:
+		unsigned int w = 0, h = 0;
+		game::Parameters params;
+		std::vector<RecordedSpawn> spawns;
+		std::vector<RecordedEvent> events;
+
+		/**
+		 * @throw std::runtime_error if file can't be read or isn't a recording.
+		 */
+		explicit Replay(const std::string& filename);
+
+		/* plant initial trees */
+		void populate(game::World& world) const;
+		/**
+		 * @brief Apply inputs which took effect after @a tick ticks.
+		 * @detail Call before every tick with ticks simulated so far, in order.
+		 */
+		void apply(game::World& world, std::uint32_t tick);
+		/* number of ticks the recorded run simulated */
+		std::uint32_t ticks() const;
+
+	private:
+		std::size_t next = 0;
+	};
+}
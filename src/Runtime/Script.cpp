@@ -0,0 +1,301 @@
+#include "Script.hpp"
+#include "Game/Trace.hpp"
+#include "Game/World.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include <entt/entity/registry.hpp>
+#include <fmt/format.h>
+extern "C" {
+#include <lauxlib.h>
+#include <lua.h>
+#include <lualib.h>
+}
+
+namespace runtime
+{
+	constexpr const char* tree_fields[] = {"id", "x", "y", "energy", "age", "max_age", "cells", "falling"};
+	constexpr const char* column_fields[] = {"top", "cells"};
+
+	/* message of error at the top of the stack, pops it */
+	static std::string pop_error(lua_State* state)
+	{
+		const char* message = lua_tostring(state, -1);
+		std::string result = message ? message : "error object isn't a string";
+		lua_pop(state, 1);
+		return result;
+	}
+
+	/* global function @a name as a reference in registry, LUA_NOREF if it isn't defined */
+	static int ref_function(lua_State* state, const char* name)
+	{
+		if (lua_getglobal(state, name) == LUA_TFUNCTION)
+			return luaL_ref(state, LUA_REGISTRYINDEX);
+		lua_pop(state, 1);
+		return LUA_NOREF;
+	}
+
+	/* table with an empty array for each of @a fields as a reference in registry */
+	template<std::size_t N>
+	static int ref_arrays(lua_State* state, const char* const (&fields)[N])
+	{
+		lua_createtable(state, 0, N + 1);
+		for (auto field : fields)
+		{
+			lua_newtable(state);
+			lua_setfield(state, -2, field);
+		}
+		lua_pushinteger(state, 0);
+		lua_setfield(state, -2, "n");
+		return luaL_ref(state, LUA_REGISTRYINDEX);
+	}
+
+	/* set element @a i of array at @a index */
+	static void set(lua_State* state, int index, lua_Integer i, lua_Integer value)
+	{
+		lua_pushinteger(state, value);
+		lua_rawseti(state, index, i);
+	}
+
+	/**
+	 * Arrays of @a fields are pushed after the table at @a table, drop their
+	 * elements after @a n which are left from a previous longer fill and
+	 * remember @a n.
+	 */
+	static void finish_arrays(lua_State* state, int table, int fields, lua_Integer n)
+	{
+		lua_getfield(state, table, "n");
+		const lua_Integer previous = lua_tointegerx(state, -1, nullptr);
+		lua_pop(state, 1);
+		for (int field = 1; field <= fields; field++)
+			for (lua_Integer i = n + 1; i <= previous; i++)
+			{
+				lua_pushnil(state);
+				lua_rawseti(state, table + field, i);
+			}
+		lua_pushinteger(state, n);
+		lua_setfield(state, table, "n");
+		lua_settop(state, table);
+	}
+
+	Script::Script(const std::string& filename)
+		: state(luaL_newstate()), filename(filename)
+	{
+		if (!state)
+			throw std::runtime_error("Can't create Lua state");
+		luaL_openlibs(state);
+		if (luaL_loadfile(state, filename.c_str()) != LUA_OK || lua_pcall(state, 0, 0, 0) != LUA_OK)
+		{
+			auto error = std::runtime_error(pop_error(state));
+			lua_close(state);
+			throw error;
+		}
+		sunHook = ref_function(state, "sun");
+		spawnHook = ref_function(state, "spawn");
+		tickEndHook = ref_function(state, "tick_end");
+
+		lua_newtable(state);
+		lua_createtable(state, 0, 1);
+		lua_pushlightuserdata(state, this);
+		lua_pushcclosure(state, &Script::index, 1);
+		lua_setfield(state, -2, "__index");
+		lua_setmetatable(state, -2);
+		worldTable = luaL_ref(state, LUA_REGISTRYINDEX);
+		lua_newtable(state);
+		lightTable = luaL_ref(state, LUA_REGISTRYINDEX);
+		treesTable = ref_arrays(state, tree_fields);
+		columnsTable = ref_arrays(state, column_fields);
+	}
+
+	Script::~Script()
+	{
+		lua_close(state);
+	}
+
+	int Script::index(lua_State* state)
+	{
+		auto script = static_cast<Script*>(lua_touserdata(state, lua_upvalueindex(1)));
+		if (lua_type(state, 2) != LUA_TSTRING || !script->current)
+			return 0;
+		const std::string_view key = lua_tostring(state, 2);
+		if (key == "trees")
+			script->pushTrees();
+		else if (key == "columns")
+			script->pushColumns();
+		else
+			return 0;
+		/* keep it in world table until the next hook */
+		lua_pushvalue(state, 2);
+		lua_pushvalue(state, -2);
+		lua_rawset(state, 1);
+		return 1;
+	}
+
+	void Script::pushTrees()
+	{
+		CURSED_TREES_TRACE("Script::pushTrees");
+		auto& registry = current->registry;
+		lua_rawgeti(state, LUA_REGISTRYINDEX, treesTable);
+		const int table = lua_gettop(state);
+		for (auto field : tree_fields)
+			lua_getfield(state, table, field);
+		lua_Integer i = 0;
+		for (auto&& [entity, tree] : registry.view<game::Tree>().each())
+		{
+			i++;
+			const auto root = tree.root();
+			const auto living = registry.try_get<game::Living>(entity);
+			set(state, table + 1, i, static_cast<std::uint32_t>(entity));
+			set(state, table + 2, i, root.x);
+			set(state, table + 3, i, root.y);
+			set(state, table + 4, i, tree.energy);
+			set(state, table + 5, i, living ? living->age : 0);
+			set(state, table + 6, i, living ? living->maxAge : 0);
+			set(state, table + 7, i, static_cast<lua_Integer>(tree.aliveCells.size() + tree.deadCells.size()));
+			lua_pushboolean(state, living == nullptr);
+			lua_rawseti(state, table + 8, i);
+		}
+		finish_arrays(state, table, std::size(tree_fields), i);
+	}
+
+	void Script::pushColumns()
+	{
+		CURSED_TREES_TRACE("Script::pushColumns");
+		const auto& world = *current;
+		/* positions of cells are only known to their trees, so count them per tree, O(cells) */
+		std::vector<lua_Integer> top(world.w), cells(world.w);
+		for (auto&& [entity, tree] : world.registry.view<game::Tree>().each())
+			for (auto list : {&tree.aliveCells, &tree.deadCells})
+				for (auto pos : *list)
+				{
+					top[pos.x] = std::max<lua_Integer>(top[pos.x], pos.y + 1);
+					cells[pos.x]++;
+				}
+		lua_rawgeti(state, LUA_REGISTRYINDEX, columnsTable);
+		const int table = lua_gettop(state);
+		for (auto field : column_fields)
+			lua_getfield(state, table, field);
+		for (unsigned int x = 0; x < world.w; x++)
+		{
+			set(state, table + 1, x + 1, top[x]);
+			set(state, table + 2, x + 1, cells[x]);
+		}
+		finish_arrays(state, table, std::size(column_fields), world.w);
+	}
+
+	void Script::prepare(int function, const game::World& world)
+	{
+		current = &world;
+		lua_rawgeti(state, LUA_REGISTRYINDEX, function);
+		lua_rawgeti(state, LUA_REGISTRYINDEX, worldTable);
+		const auto stats = game::gather_statistics(world);
+		auto field = [&](const char* name, lua_Integer value) {
+			lua_pushinteger(state, value);
+			lua_setfield(state, -2, name);
+		};
+		field("year", world.year);
+		field("width", world.w);
+		field("height", world.h);
+		field("min_sun", world.params.minSun);
+		field("sun_levels", world.params.sunLevels);
+		field("upkeep", world.params.upkeep);
+		field("trees_count", static_cast<lua_Integer>(stats.trees));
+		field("seeds", static_cast<lua_Integer>(stats.seeds));
+		field("cells", static_cast<lua_Integer>(stats.cells));
+		field("energy", stats.energy);
+		field("species", static_cast<lua_Integer>(stats.species));
+		/* arrays of the previous hook are stale */
+		for (auto name : {"trees", "columns"})
+		{
+			lua_pushnil(state);
+			lua_setfield(state, -2, name);
+		}
+	}
+
+	void Script::call(const char* hook, int args, int results)
+	{
+		CURSED_TREES_TRACE("Script::call");
+		if (lua_pcall(state, args, results, 0) != LUA_OK)
+			throw std::runtime_error(fmt::format("{}() of {} failed: {}", hook, filename, pop_error(state)));
+	}
+
+	std::span<const game::SpawnRequest> Script::spawn(const game::World& world)
+	{
+		if (spawnHook == LUA_NOREF)
+			return {};
+		prepare(spawnHook, world);
+		call("spawn", 1, 2);
+		const int columns = lua_gettop(state) - 1, energies = columns + 1;
+		spawns.clear();
+		if (lua_istable(state, columns))
+		{
+			const auto n = static_cast<lua_Integer>(lua_rawlen(state, columns));
+			for (lua_Integer i = 1; i <= n; i++)
+			{
+				int isX = 0, isEnergy = 1;
+				lua_rawgeti(state, columns, i);
+				const auto x = lua_tointegerx(state, -1, &isX);
+				game::SpawnRequest request{static_cast<unsigned int>(x)};
+				if (lua_istable(state, energies))
+				{
+					lua_rawgeti(state, energies, i);
+					if (!lua_isnil(state, -1))
+						request.energy = static_cast<int>(lua_tointegerx(state, -1, &isEnergy));
+					lua_pop(state, 1);
+				}
+				lua_pop(state, 1);
+				if (!isX || !isEnergy)
+				{
+					lua_settop(state, columns - 1);
+					throw std::runtime_error(fmt::format("spawn() of {} returned a column or energy which isn't an integer", filename));
+				}
+				if (x >= 0 && x < static_cast<lua_Integer>(world.w))
+					spawns.push_back(request);
+			}
+		}
+		else if (!lua_isnil(state, columns))
+		{
+			lua_settop(state, columns - 1);
+			throw std::runtime_error(fmt::format("spawn() of {} must return an array of columns", filename));
+		}
+		lua_settop(state, columns - 1);
+		return spawns;
+	}
+
+	std::span<const int> Script::sun(const game::World& world)
+	{
+		if (sunHook == LUA_NOREF)
+			return {};
+		prepare(sunHook, world);
+		lua_rawgeti(state, LUA_REGISTRYINDEX, lightTable);
+		for (unsigned int x = 0; x < world.w; x++)
+			set(state, -2, x + 1, world.params.minSun);
+		call("sun", 2, 0);
+		lua_rawgeti(state, LUA_REGISTRYINDEX, lightTable);
+		light.resize(world.w);
+		for (unsigned int x = 0; x < world.w; x++)
+		{
+			int isNumber = 0;
+			lua_rawgeti(state, -1, x + 1);
+			light[x] = static_cast<int>(lua_tointegerx(state, -1, &isNumber));
+			lua_pop(state, 1);
+			if (!isNumber)
+			{
+				lua_pop(state, 1);
+				throw std::runtime_error(fmt::format("sun() of {} set light[{}] to something which isn't an integer",
+													 filename, x + 1));
+			}
+		}
+		lua_pop(state, 1);
+		return light;
+	}
+
+	void Script::tickEnd(const game::World& world)
+	{
+		if (tickEndHook == LUA_NOREF)
+			return;
+		prepare(tickEndHook, world);
+		call("tick_end", 1, 0);
+	}
+}
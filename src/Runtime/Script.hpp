@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Game/Hooks.hpp"
+
+#include <span>
+#include <string>
+#include <vector>
+
+struct lua_State;
+
+namespace runtime
+{
+	/**
+	 * @brief game::Hooks defined by a Lua script.
+	 * @detail The script may define any of these global functions, each is
+	 * called once per tick with a table describing the world:
+	 *   sun(world, light) - light[x+1] is the sun of column x, initially
+	 *     Parameters::minSun, change it in place;
+	 *   spawn(world) - returns an array of columns to spawn trees at and
+	 *     optionally an array of their energies;
+	 *   tick_end(world) - called after the tick.
+	 * world has scalar fields year, width, height, min_sun, sun_levels,
+	 * upkeep, trees_count, seeds, cells, energy and species. world.trees and
+	 * world.columns are tables of arrays (id, x, y, energy, age, max_age,
+	 * cells, falling and top), they are filled on first access in a hook, so
+	 * scripts which don't read them don't pay for them. Columns and positions
+	 * start at 0 like everywhere else, arrays start at 1 like in Lua.
+	 */
+	class Script : public game::Hooks
+	{
+	public:
+		/* @throw std::runtime_error if the script can't be loaded or fails to run */
+		explicit Script(const std::string& filename);
+		~Script();
+
+		Script(const Script&) = delete;
+		Script& operator=(const Script&) = delete;
+
+		/* hooks throw std::runtime_error when the script fails */
+		std::span<const game::SpawnRequest> spawn(const game::World& world) override;
+		std::span<const int> sun(const game::World& world) override;
+		void tickEnd(const game::World& world) override;
+
+	private:
+		/* __index of world table, fills trees and columns on first access */
+		static int index(lua_State* state);
+		/* push arrays of trees and columns of the current world */
+		void pushTrees();
+		void pushColumns();
+		/* push hook @a function and world table refreshed for @a world */
+		void prepare(int function, const game::World& world);
+		/* call what prepare() pushed with @a args more arguments */
+		void call(const char* hook, int args, int results);
+
+		lua_State* state;
+		std::string filename;
+		/* references to hooks in registry, LUA_NOREF when script doesn't define them */
+		int sunHook, spawnHook, tickEndHook;
+		/* references to world, light and arrays tables which are reused every tick */
+		int worldTable, lightTable, treesTable, columnsTable;
+		/* world hooks are called for, valid during a hook */
+		const game::World* current = nullptr;
+		std::vector<int> light;
+		std::vector<game::SpawnRequest> spawns;
+	};
+}
@@ -0,0 +1,211 @@
+#include "SharedFrames.hpp"
+#include "Simulation.hpp"
+#include "Game/Renderer.hpp"
+#include "Game/Statistics.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace runtime
+{
+	constexpr std::size_t frame_slots = 4;
+
+	static std::size_t align(std::size_t size)
+	{
+		return (size + 63) & ~std::size_t(63);
+	}
+
+	static std::size_t slot_size(std::size_t w, std::size_t h)
+	{
+		return align(sizeof(FrameInfo) + w * h * sizeof(std::uint16_t));
+	}
+
+	static std::size_t memory_size(std::size_t w, std::size_t h, std::size_t slots)
+	{
+		return align(sizeof(FrameHeader)) + slots * slot_size(w, h);
+	}
+
+	template<typename H>
+	static auto* slot(H* header, std::uint64_t frame)
+	{
+		using byte = std::conditional_t<std::is_const_v<H>, const char, char>;
+		auto* base = reinterpret_cast<byte*>(header) + align(sizeof(FrameHeader));
+		return base + frame % header->slots * slot_size(header->width, header->height);
+	}
+
+	/* Displayer for game::Renderer which writes tiles to a slot */
+	struct SlotDisplayer
+	{
+		std::uint16_t* tiles = nullptr;
+		int w = 0, h = 0;
+
+		int width() const { return w; }
+		int height() const { return h; }
+		void begin() {}
+		void end() {}
+		void draw(unsigned y, unsigned x, char ch, unsigned color) { tiles[y * w + x] = Snapshot::pack(ch, color); }
+		void onScroll() {}
+	};
+
+	/* remove frames a publisher left behind when it died or stopped,
+	   throw if @a name is used by a running publisher or by something else */
+	static void remove_stale(const std::string& name)
+	{
+		int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+		if (fd < 0)
+		{
+			if (errno == ENOENT)
+				return;
+			throw std::runtime_error("Can't open shared memory " + name + ": " + std::strerror(errno));
+		}
+		struct stat st;
+		void* memory = MAP_FAILED;
+		if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(FrameHeader))
+			memory = ::mmap(nullptr, sizeof(FrameHeader), PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (memory == MAP_FAILED)
+			throw std::runtime_error("Shared memory " + name + " is in use by something else");
+		auto* header = static_cast<const FrameHeader*>(memory);
+		const bool frames = header->magic == FrameHeader::magic_value &&
+			header->version == FrameHeader::current_version;
+		const bool stale = frames && (header->closed.load(std::memory_order_acquire) ||
+									  (::kill(header->pid, 0) < 0 && errno == ESRCH));
+		const auto pid = header->pid;
+		::munmap(memory, sizeof(FrameHeader));
+		if (!frames)
+			throw std::runtime_error("Shared memory " + name + " is in use by something else");
+		if (!stale)
+			throw std::runtime_error("Name " + name + " is in use by process " + std::to_string(pid)
+									 + " which publishes to it");
+		::shm_unlink(name.c_str());
+	}
+
+	FramePublisher::FramePublisher(const std::string& name, unsigned int w, unsigned int h,
+								   std::chrono::steady_clock::duration interval)
+		: name(name), size(memory_size(w, h, frame_slots)), interval(interval)
+	{
+		remove_stale(name);
+		/* fails if another publisher took the name since */
+		int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+		if (fd < 0)
+			throw std::runtime_error("Can't create shared memory " + name + ": " + std::strerror(errno));
+		if (::ftruncate(fd, size) < 0 ||
+			(memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+		{
+			auto error = std::runtime_error("Can't map shared memory " + name + ": " + std::strerror(errno));
+			::close(fd);
+			::shm_unlink(name.c_str());
+			throw error;
+		}
+		::close(fd);
+		/* memory is zeroed, so every slot starts with an even sequence */
+		auto* header = new(memory) FrameHeader{FrameHeader::magic_value, FrameHeader::current_version, w, h,
+											   frame_slots, static_cast<std::int32_t>(::getpid()), {0}, {0}};
+		for (std::size_t i = 0; i < frame_slots; i++)
+			new(slot(header, i)) FrameInfo{};
+	}
+
+	FramePublisher::~FramePublisher()
+	{
+		static_cast<FrameHeader*>(memory)->closed.store(1, std::memory_order_release);
+		::munmap(memory, size);
+		::shm_unlink(name.c_str());
+	}
+
+	void FramePublisher::update(game::World& world, int year)
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (now < next)
+			return;
+		next = now + interval;
+		publish(world, year);
+	}
+
+	void FramePublisher::publish(game::World& world, int year)
+	{
+		CURSED_TREES_TRACE("FramePublisher::publish");
+		auto* header = static_cast<FrameHeader*>(memory);
+		const std::uint64_t frame = header->latest.load(std::memory_order_relaxed) + 1;
+		auto* data = slot(header, frame);
+		auto* info = reinterpret_cast<FrameInfo*>(data);
+		const auto sequence = info->sequence.load(std::memory_order_relaxed);
+		info->sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		auto stats = game::gather_statistics(world);
+		info->frame = frame;
+		info->year = year;
+		info->trees = stats.trees;
+		info->seeds = stats.seeds;
+		info->cells = stats.cells;
+		info->energy = stats.energy;
+		info->hash = world.hash;
+		auto* tiles = reinterpret_cast<std::uint16_t*>(data + sizeof(FrameInfo));
+		game::Renderer<SlotDisplayer> renderer{world, SlotDisplayer{tiles, int(header->width), int(header->height)}};
+		renderer.render(false);
+
+		info->sequence.store(sequence + 2, std::memory_order_release);
+		header->latest.store(frame, std::memory_order_release);
+	}
+
+	FrameReader::FrameReader(const std::string& name)
+	{
+		int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+		if (fd < 0)
+			throw std::runtime_error("Nothing is published to " + name + ": " + std::strerror(errno));
+		struct stat st;
+		void* memory = MAP_FAILED;
+		if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(FrameHeader))
+			memory = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (memory == MAP_FAILED)
+			throw std::runtime_error("Can't map shared memory " + name);
+		header = static_cast<const FrameHeader*>(memory);
+		size = st.st_size;
+		if (header->magic != FrameHeader::magic_value || header->version != FrameHeader::current_version ||
+			header->slots == 0 || size < memory_size(header->width, header->height, header->slots))
+		{
+			::munmap(memory, size);
+			throw std::runtime_error(name + " has frames of another version");
+		}
+	}
+
+	FrameReader::~FrameReader()
+	{
+		::munmap(const_cast<FrameHeader*>(header), size);
+	}
+
+	bool FrameReader::closed() const noexcept
+	{
+		return header->closed.load(std::memory_order_acquire) ||
+			(::kill(header->pid, 0) < 0 && errno == ESRCH);
+	}
+
+	FrameReader::Frame FrameReader::latest(std::uint64_t after) const noexcept
+	{
+		const auto frame = header->latest.load(std::memory_order_acquire);
+		if (frame <= after)
+			return {};
+		const char* data = slot(header, frame);
+		auto* info = reinterpret_cast<const FrameInfo*>(data);
+		const auto sequence = info->sequence.load(std::memory_order_acquire);
+		if (sequence & 1) /* publisher already got around to this slot again */
+			return {};
+		return {info, reinterpret_cast<const std::uint16_t*>(data + sizeof(FrameInfo)), sequence};
+	}
+
+	bool FrameReader::valid(const Frame& frame) const noexcept
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return frame.info && frame.info->sequence.load(std::memory_order_relaxed) == frame.sequence;
+	}
+}
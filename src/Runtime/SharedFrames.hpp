@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace game
+{
+	class World;
+}
+
+namespace runtime
+{
+	/**
+	 * @brief Beginning of shared memory with frames.
+	 * @detail Followed by `slots` slots, each a FrameInfo and width * height
+	 * tiles packed like in Snapshot, rows from top to bottom.
+	 */
+	struct FrameHeader
+	{
+		static constexpr std::uint32_t magic_value = 0x52465443; /* "CTFR" */
+		static constexpr std::uint32_t current_version = 1;
+
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t width, height;
+		std::uint32_t slots;
+		/* process which publishes frames */
+		std::int32_t pid;
+		/* set when publisher stops */
+		std::atomic<std::uint32_t> closed;
+		/* number of the last complete frame, it is in slot latest % slots */
+		std::atomic<std::uint64_t> latest;
+	};
+
+	/**
+	 * @brief Statistics of a published frame.
+	 */
+	struct FrameInfo
+	{
+		/* even when the slot is complete, odd while it is being written */
+		std::atomic<std::uint64_t> sequence;
+		std::uint64_t frame;
+		std::int64_t year;
+		std::uint64_t trees, seeds, cells;
+		std::int64_t energy;
+		std::uint64_t hash;
+	};
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+				  "shared memory needs address free atomics");
+
+	/**
+	 * @brief Renders the whole world into a ring of frames in POSIX shared
+	 * memory which viewers may map at any moment.
+	 * @detail Single writer, lock free: a frame's slot is guarded by a
+	 * sequence number (seqlock), so readers never block the simulation and
+	 * simply skip frames overwritten while they were reading.
+	 */
+	class FramePublisher
+	{
+	public:
+		/**
+		 * @param name shared memory object, e.g. "/cursed-trees"
+		 * @detail Frames left behind by a publisher which died or stopped
+		 * are removed, a name in use by a running one is never taken over.
+		 * @param interval publish at most once per interval
+		 * @throw std::runtime_error if @a name is in use by a running
+		 * publisher or isn't a publisher's, or shared memory can't be created
+		 */
+		FramePublisher(const std::string& name, unsigned int w, unsigned int h,
+					   std::chrono::steady_clock::duration interval = std::chrono::milliseconds{33});
+		/* marks frames closed and removes the shared memory object */
+		~FramePublisher();
+
+		FramePublisher(const FramePublisher&) = delete;
+		FramePublisher& operator=(const FramePublisher&) = delete;
+
+		/**
+		 * @brief Publish @a world if interval passed since the last frame,
+		 * call after every tick.
+		 */
+		void update(game::World& world, int year);
+		/* publish @a world now */
+		void publish(game::World& world, int year);
+
+	private:
+		std::string name;
+		void* memory = nullptr;
+		std::size_t size = 0;
+		std::chrono::steady_clock::duration interval;
+		std::chrono::steady_clock::time_point next;
+	};
+
+	/**
+	 * @brief Read only view of frames of a FramePublisher, possibly in other process.
+	 */
+	class FrameReader
+	{
+	public:
+		/* tiles point straight into shared memory */
+		struct Frame
+		{
+			const FrameInfo* info = nullptr;
+			const std::uint16_t* tiles = nullptr;
+			std::uint64_t sequence = 0;
+		};
+
+		/**
+		 * @throw std::runtime_error if there is no such publisher or it has
+		 * another layout
+		 */
+		explicit FrameReader(const std::string& name);
+		~FrameReader();
+
+		FrameReader(const FrameReader&) = delete;
+		FrameReader& operator=(const FrameReader&) = delete;
+
+		unsigned int width() const noexcept { return header->width; }
+		unsigned int height() const noexcept { return header->height; }
+		/* publisher stopped or died */
+		bool closed() const noexcept;
+
+		/**
+		 * @brief Newest frame if its number is greater than @a after.
+		 * @return frame with null info if there is none.
+		 * @note Tiles may be overwritten while they are read, check valid()
+		 * after using them.
+		 */
+		Frame latest(std::uint64_t after) const noexcept;
+		/* @a frame wasn't overwritten since latest() returned it */
+		bool valid(const Frame& frame) const noexcept;
+
+	private:
+		const FrameHeader* header = nullptr;
+		std::size_t size = 0;
+	};
+}
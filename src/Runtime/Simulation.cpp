@@ -0,0 +1,286 @@
+#include "Simulation.hpp"
+
+#include <cstring>
+#include <entt/entity/registry.hpp>
+
+namespace runtime
+{
+	using namespace std::chrono_literals;
+
+	void RateCounter::update(clock::time_point now)
+	{
+		using namespace std::chrono;
+		auto elapsed = duration_cast<milliseconds>(now - since).count();
+		if (elapsed >= 1000)
+		{
+			rate = static_cast<int>(count * 1000 / elapsed);
+			count = 0;
+			since = now;
+		}
+	}
+
+	Simulation::Simulation(game::World& world, const Settings& settings)
+		: world(world), renderer(world, SnapshotDisplayer{&back}), recorder(settings.recorder), publisher(settings.publisher), metrics(settings.metrics), settings(settings)
+		, year(static_cast<int>(world.year))
+	{
+		/* answer tree requests even while paused */
+		if (metrics)
+			metrics->onRequest([this]() { wakeup.signal(); });
+	}
+
+	Simulation::~Simulation()
+	{
+		stop();
+		if (metrics)
+			metrics->onRequest(nullptr);
+	}
+
+	void Simulation::start()
+	{
+		thread = std::thread(&Simulation::run, this);
+	}
+
+	void Simulation::stop()
+	{
+		{
+			std::lock_guard lock(mutex);
+			quit = true;
+			wakeup.signal();
+		}
+		if (thread.joinable())
+			thread.join();
+	}
+
+	void Simulation::pause(bool paused)
+	{
+		std::lock_guard lock(mutex);
+		settings.paused = paused;
+		changed = true;
+		wakeup.signal();
+	}
+
+	void Simulation::setTicksPerSecond(int ticksPerSecond)
+	{
+		std::lock_guard lock(mutex);
+		settings.ticksPerSecond = ticksPerSecond;
+		wakeup.signal();
+	}
+
+	void Simulation::setMinSun(int minSun)
+	{
+		post([this, minSun](game::World& world) {
+			world.params.minSun = minSun;
+			if (recorder)
+				recorder->record(year, RecordedEvent::Type::MIN_SUN, minSun);
+		});
+	}
+
+	void Simulation::setMutationChance(float mutationChance)
+	{
+		post([this, mutationChance](game::World& world) {
+			world.params.mutationChance = mutationChance;
+			std::int32_t bits;
+			std::memcpy(&bits, &mutationChance, sizeof(bits));
+			if (recorder)
+				recorder->record(year, RecordedEvent::Type::MUTATION_CHANCE, bits);
+		});
+	}
+
+	void Simulation::setViewport(const Viewport& viewport_)
+	{
+		std::lock_guard lock(mutex);
+		viewport = viewport_;
+		changed = true;
+		wakeup.signal();
+	}
+
+	void Simulation::fastForward(int ticks)
+	{
+		std::lock_guard lock(mutex);
+		skipRequest += ticks;
+		wakeup.signal();
+	}
+
+	void Simulation::cancel()
+	{
+		std::lock_guard lock(mutex);
+		cancelRequest = true;
+		skipRequest = 0;
+		wakeup.signal();
+	}
+
+	void Simulation::post(std::function<void(game::World&)> command)
+	{
+		std::lock_guard lock(mutex);
+		commands.push_back(std::move(command));
+		wakeup.signal();
+	}
+
+	bool Simulation::acquire(Snapshot& snapshot)
+	{
+		std::lock_guard lock(mutex);
+		if (!fresh)
+			return false;
+		std::swap(snapshot, pending);
+		fresh = false;
+		return true;
+	}
+
+	void Simulation::rethrow()
+	{
+		std::lock_guard lock(mutex);
+		if (error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+	}
+
+	void Simulation::run()
+	{
+		/* spend at most this much time on ticks before publishing a snapshot */
+		constexpr auto budget = 50ms;
+		game::trace::name_thread("simulation");
+		auto nextTick = clock::now();
+		std::vector<std::function<void(game::World&)>> todo;
+		std::unique_lock lock(mutex);
+		try
+		{
+			while (!quit)
+			{
+				todo.swap(commands);
+				const Settings current = settings;
+				const Viewport view = viewport;
+				bool dirty = std::exchange(changed, false);
+				if (recorder && recordedPause != current.paused)
+				{
+					recordedPause = current.paused;
+					recorder->record(year, RecordedEvent::Type::PAUSE, current.paused);
+				}
+				if (skipRequest)
+				{
+					if (recorder)
+						recorder->record(year, RecordedEvent::Type::SKIP, skipRequest);
+					if (!skipping)
+					{
+						skips++;
+						skipping = true;
+						skipCancelled = false;
+						skipDone = skipTotal = 0;
+					}
+					skipTotal += std::exchange(skipRequest, 0);
+				}
+				if (std::exchange(cancelRequest, false) && skipping)
+				{
+					if (recorder)
+						recorder->record(year, RecordedEvent::Type::CANCEL);
+					skipping = false;
+					skipCancelled = true;
+					dirty = true;
+				}
+				lock.unlock();
+
+				for (auto& command : todo)
+				{
+					CURSED_TREES_TRACE("Simulation::command");
+					command(world);
+				}
+				dirty |= !todo.empty();
+				todo.clear();
+
+				auto now = clock::now();
+				if (skipping)
+				{
+					while (skipDone < skipTotal && clock::now() < now + budget)
+					{
+						tick();
+						skipDone++;
+					}
+					skipping = skipDone < skipTotal;
+					nextTick = clock::now();
+					dirty = true;
+				}
+				else if (!current.paused)
+				{
+					const auto period = std::chrono::duration_cast<clock::duration>(1s) / current.ticksPerSecond;
+					while (nextTick <= now && clock::now() < now + budget)
+					{
+						tick();
+						nextTick += period;
+						dirty = true;
+					}
+					if (nextTick <= now) /* can't keep up, drop the backlog */
+						nextTick = now;
+				}
+				else nextTick = now;
+
+				if (metrics)
+					metrics->update(world);
+
+				int rate = tps.rate;
+				tps.update(clock::now());
+				dirty |= rate != tps.rate;
+				if (dirty)
+					publish(view);
+
+				lock.lock();
+				if (skipping || quit || changed || skipRequest || cancelRequest || !commands.empty())
+					continue;
+				const bool paused = settings.paused;
+				lock.unlock();
+
+				/* anything UI sends from now on signals wakeup, so nothing gets lost */
+				if (paused) timer.disarm();
+				else timer.arm(nextTick);
+				wait({wakeup.handle(), timer.handle()});
+				wakeup.consume();
+				timer.consume();
+				lock.lock();
+			}
+			if (recorder)
+				recorder->record(year, RecordedEvent::Type::END);
+		}
+		catch (...)
+		{
+			if (!lock.owns_lock())
+				lock.lock();
+			error = std::current_exception();
+			fresh = false;
+		}
+	}
+
+	void Simulation::tick()
+	{
+		alive = world.tick();
+		year++;
+		if (publisher)
+			publisher->update(world, year);
+		tps.add();
+	}
+
+	void Simulation::publish(const Viewport& view)
+	{
+		CURSED_TREES_TRACE("Simulation::publish");
+		back.viewport = view;
+		renderer.x = view.x;
+		renderer.y = view.y;
+		renderer.render(view.energyMode);
+		back.trees = world.registry.size<game::Tree>();
+		back.year = year;
+		back.hash = world.hash;
+		back.ticksPerSecond = tps.rate;
+		back.alive = alive;
+		back.skips = skips;
+		back.skipping = skipping;
+		back.skipCancelled = skipCancelled;
+		back.skipDone = skipDone;
+		back.skipTotal = skipTotal;
+		back.profile = world.profile;
+		back.history.clear();
+		for (std::size_t i = 0; i < world.history.size(); i++)
+			back.history.push_back(world.history[i]);
+		world.population.ages(world.year, back.ages);
+
+		std::lock_guard lock(mutex);
+		std::swap(back, pending);
+		fresh = true;
+		publishedEvent.signal();
+	}
+}
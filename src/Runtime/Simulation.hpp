@@ -0,0 +1,214 @@
+#pragma once
+
+#include "Events.hpp"
+#include "Metrics.hpp"
+#include "Recording.hpp"
+#include "SharedFrames.hpp"
+#include "Game/Renderer.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace runtime
+{
+	/**
+	 * @brief Counts events and measures their rate over one second windows.
+	 */
+	struct RateCounter
+	{
+		using clock = std::chrono::steady_clock;
+
+		int count = 0;
+		int rate = 0;
+		clock::time_point since = clock::now();
+
+		void add(int n = 1) { count += n; }
+		void update(clock::time_point now);
+	};
+
+	/**
+	 * @brief Part of world which is visible on screen.
+	 */
+	struct Viewport
+	{
+		int x = 0, y = 0;
+		int width = 0, height = 0;
+		bool energyMode = false;
+	};
+
+	/**
+	 * @brief Everything UI needs to draw a frame. Produced by simulation thread.
+	 */
+	struct Snapshot
+	{
+		Viewport viewport;
+		/* tiles of viewport, row by row: character in low byte, color index in high byte */
+		std::vector<uint16_t> tiles;
+		std::size_t trees = 0;
+		int year = 0;
+		/* world's state hash, see game::World::hash */
+		std::uint64_t hash = 0;
+		/* measured ticks per second */
+		int ticksPerSecond = 0;
+		bool alive = true;
+		/* fast forward progress, skips counts fast forwards started so far */
+		int skips = 0;
+		bool skipping = false;
+		bool skipCancelled = false;
+		int skipDone = 0;
+		int skipTotal = 0;
+		/* timings and counters of the last tick, see game::TickProfile */
+		game::TickProfile profile;
+		/* statistics of the last ticks, oldest first, see game::World::history */
+		std::vector<game::Statistics> history;
+		/* living trees by age, see game::Population::ages */
+		std::array<unsigned int, 10> ages{};
+
+		static constexpr uint16_t pack(char ch, unsigned color)
+		{
+			return static_cast<uint16_t>(static_cast<unsigned char>(ch) | (color << 8));
+		}
+		static constexpr char character(uint16_t tile) { return static_cast<char>(tile & 0xFF); }
+		static constexpr unsigned color(uint16_t tile) { return tile >> 8; }
+	};
+
+	/**
+	 * @brief Displayer for game::Renderer which writes tiles to a snapshot.
+	 */
+	struct SnapshotDisplayer
+	{
+		Snapshot* target = nullptr;
+
+		int width() const { return target->viewport.width; }
+		int height() const { return target->viewport.height; }
+		void begin()
+		{
+			target->tiles.assign(static_cast<std::size_t>(width() * height()), Snapshot::pack(' ', 0));
+		}
+		void end() {}
+		void draw(unsigned y, unsigned x, char ch, unsigned color)
+		{
+			target->tiles[y * width() + x] = Snapshot::pack(ch, color);
+		}
+		void onScroll() {}
+	};
+
+	/**
+	 * @brief Advances a world on a dedicated thread.
+	 * @detail All methods are meant to be called from UI thread. The world must
+	 * not be touched by anyone else while simulation is running, use post() to
+	 * access it. Rendered snapshots are handed to UI by swapping buffers so
+	 * neither side copies tiles. Simulation thread sleeps on a timerfd between
+	 * ticks and doesn't wake up at all while paused.
+	 */
+	class Simulation
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+		struct Settings
+		{
+			bool paused = true;
+			int ticksPerSecond = 5;
+			/* records inputs when set, used by simulation thread only */
+			Recorder* recorder = nullptr;
+			/* publishes frames for detached viewers when set, used by simulation thread only */
+			FramePublisher* publisher = nullptr;
+			/* serves metrics over HTTP when set, must outlive simulation */
+			MetricsServer* metrics = nullptr;
+		};
+
+		Simulation(game::World& world, const Settings& settings);
+		~Simulation();
+
+		Simulation(const Simulation&) = delete;
+		Simulation& operator=(const Simulation&) = delete;
+
+		void start();
+		void stop();
+
+		void pause(bool paused);
+		void setTicksPerSecond(int ticksPerSecond);
+		void setMinSun(int minSun);
+		void setMutationChance(float mutationChance);
+		void setViewport(const Viewport& viewport);
+		/**
+		 * @brief Run @a ticks ticks as fast as possible. Progress is reported in snapshots.
+		 */
+		void fastForward(int ticks);
+		/**
+		 * @brief Cancel running fast forward.
+		 */
+		void cancel();
+		/**
+		 * @brief Run @a command on simulation thread between ticks.
+		 */
+		void post(std::function<void(game::World&)> command);
+
+		/**
+		 * @brief Take latest snapshot if a new one was published since last call.
+		 * @return true if @a snapshot was replaced.
+		 */
+		bool acquire(Snapshot& snapshot);
+		/**
+		 * @brief Rethrow exception which stopped simulation thread, if any.
+		 */
+		void rethrow();
+		/**
+		 * @brief Event signalled every time a new snapshot is published.
+		 * @detail Wait for its handle with runtime::wait() and consume it
+		 * before calling acquire().
+		 */
+		EventFd& published() noexcept { return publishedEvent; }
+
+	private:
+		void run();
+		void tick();
+		void publish(const Viewport& viewport);
+
+		game::World& world;
+		game::Renderer<SnapshotDisplayer> renderer;
+		Recorder* const recorder;
+		FramePublisher* const publisher;
+		MetricsServer* const metrics;
+		std::thread thread;
+
+		/* wakes simulation thread when UI changes something */
+		EventFd wakeup;
+		/* fires when next tick is due */
+		TimerFd timer;
+		EventFd publishedEvent;
+
+		/* shared with UI thread, guarded by mutex */
+		std::mutex mutex;
+		Settings settings;
+		Viewport viewport;
+		std::vector<std::function<void(game::World&)>> commands;
+		int skipRequest = 0;
+		bool cancelRequest = false;
+		bool changed = true;
+		bool quit = false;
+		Snapshot pending;
+		bool fresh = false;
+		std::exception_ptr error;
+
+		/* owned by simulation thread */
+		Snapshot back;
+		int recordedPause = -1;
+		int year = 0;
+		bool alive = true;
+		int skips = 0;
+		bool skipping = false;
+		bool skipCancelled = false;
+		int skipDone = 0;
+		int skipTotal = 0;
+		RateCounter tps;
+	};
+}
@@ -0,0 +1,173 @@
+#include "StripeWorld.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/socket.h>
+#include <fmt/core.h>
+
+namespace runtime
+{
+	namespace
+	{
+		constexpr std::size_t header = sizeof(std::uint32_t);
+
+		std::runtime_error system_error(const std::string& what)
+		{
+			return std::runtime_error(what + ": " + std::strerror(errno));
+		}
+
+		game::Parameters stripe_parameters(game::Parameters params, int index)
+		{
+			params.seed += static_cast<unsigned int>(index);
+			/* 0 would pick a random seed */
+			if (params.seed == 0)
+				params.seed = 1;
+			return params;
+		}
+
+		const char* side_name(int side)
+		{
+			return side == game::Border::LEFT ? "left" : "right";
+		}
+	}
+
+	StripeWorld::StripeWorld(unsigned int w, unsigned int h, const game::Parameters& params, int index, int stripes,
+							 int left, int right)
+		: Border(h), index(index), stripes(stripes), x0(column(w, stripes, index)), x1(column(w, stripes, index + 1))
+		, world(registry, x1 - x0, h, stripe_parameters(params, index)), peers{left, right}
+	{
+		if (stripes > 1)
+			world.border = this;
+	}
+
+	void StripeWorld::spawn(const std::vector<RecordedSpawn>& spawns)
+	{
+		for (auto& spawn : spawns)
+			if (spawn.x >= x0 && spawn.x < x1 && registry.orphan(world.at({spawn.x - x0, 0})))
+				game::Tree::spawn(world, spawn.x - x0, spawn.energy);
+	}
+
+	bool StripeWorld::tick()
+	{
+		return world.tick();
+	}
+
+	void StripeWorld::exchangeEdges(const game::World&)
+	{
+		std::string out[2], in[2];
+		for (int side : {LEFT, RIGHT})
+		{
+			const unsigned int x = side == LEFT ? 0 : world.w - 1;
+			out[side].resize(world.h);
+			for (unsigned int y = 0; y < world.h; y++)
+				out[side][y] = !registry.orphan(world.at({x, y}));
+		}
+		exchange(out, in);
+		for (int side : {LEFT, RIGHT})
+		{
+			if (in[side].size() != world.h)
+				throw std::runtime_error(fmt::format("Stripe {} got a malformed edge from its {} neighbour",
+													 index, side_name(side)));
+			for (unsigned int y = 0; y < world.h; y++)
+				occupied[side][y] = in[side][y] != 0;
+		}
+	}
+
+	void StripeWorld::exchangeBuds(const game::World&)
+	{
+		std::string out[2], in[2];
+		for (int side : {LEFT, RIGHT})
+		{
+			out[side].assign(reinterpret_cast<const char*>(buds[side].data()), buds[side].size() * sizeof(game::Bud));
+			buds[side].clear();
+		}
+		exchange(out, in);
+		for (int side : {LEFT, RIGHT})
+		{
+			auto malformed = [&]() {
+				return std::runtime_error(fmt::format("Stripe {} got malformed buds from its {} neighbour",
+													  index, side_name(side)));
+			};
+			if (in[side].size() % sizeof(game::Bud) != 0)
+				throw malformed();
+			received[side].resize(in[side].size() / sizeof(game::Bud));
+			std::memcpy(received[side].data(), in[side].data(), in[side].size());
+			for (auto& bud : received[side])
+				if (bud.y >= world.h || bud.activeGene >= game::Genom::num_genes)
+					throw malformed();
+		}
+	}
+
+	void StripeWorld::exchange(std::string (&out)[2], std::string (&in)[2])
+	{
+		/* both neighbours send at once, sending and receiving together keeps full socket buffers from blocking */
+		std::size_t sent[2] = {}, got[2] = {};
+		for (int side : {LEFT, RIGHT})
+		{
+			const std::uint32_t size = out[side].size();
+			out[side].insert(0, reinterpret_cast<const char*>(&size), header);
+			in[side].assign(header, '\0');
+		}
+		for (;;)
+		{
+			pollfd pfds[2];
+			int sides[2];
+			nfds_t count = 0;
+			for (int side : {LEFT, RIGHT})
+			{
+				const short events = (sent[side] < out[side].size() ? POLLOUT : 0)
+					| (got[side] < in[side].size() ? POLLIN : 0);
+				if (events)
+				{
+					pfds[count] = {peers[side], events, 0};
+					sides[count++] = side;
+				}
+			}
+			if (count == 0)
+				break;
+			if (::poll(pfds, count, -1) < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				throw system_error(fmt::format("Stripe {} can't wait for its neighbours", index));
+			}
+			for (nfds_t k = 0; k < count; k++)
+			{
+				const int side = sides[k];
+				if (sent[side] < out[side].size() && (pfds[k].revents & (POLLOUT | POLLERR)))
+				{
+					auto n = ::send(peers[side], out[side].data() + sent[side], out[side].size() - sent[side],
+									MSG_NOSIGNAL | MSG_DONTWAIT);
+					if (n < 0 && errno != EAGAIN && errno != EINTR)
+						throw system_error(fmt::format("Stripe {} can't send to its {} neighbour",
+													   index, side_name(side)));
+					if (n > 0)
+						sent[side] += n;
+				}
+				if (got[side] < in[side].size() && (pfds[k].revents & (POLLIN | POLLHUP | POLLERR)))
+				{
+					auto n = ::recv(peers[side], in[side].data() + got[side], in[side].size() - got[side],
+									MSG_DONTWAIT);
+					if (n == 0)
+						throw std::runtime_error(fmt::format("Stripe {}'s {} neighbour exited", index, side_name(side)));
+					if (n < 0 && errno != EAGAIN && errno != EINTR)
+						throw system_error(fmt::format("Stripe {} can't receive from its {} neighbour",
+													   index, side_name(side)));
+					if (n > 0)
+						got[side] += n;
+					if (got[side] == header && in[side].size() == header)
+					{
+						std::uint32_t size;
+						std::memcpy(&size, in[side].data(), header);
+						in[side].resize(header + size);
+					}
+				}
+			}
+		}
+		for (int side : {LEFT, RIGHT})
+			in[side].erase(0, header);
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Recording.hpp"
+#include "Game/World.hpp"
+
+#include <string>
+#include <vector>
+#include <entt/entity/registry.hpp>
+
+namespace runtime
+{
+	/**
+	 * @brief Columns [x0, x1) of a world split into vertical stripes, which
+	 * one process simulates with game::World while processes of the other
+	 * stripes simulate theirs.
+	 * @detail Stripes form a ring: the last one is the left neighbour of the
+	 * first, so the world wraps around like one World does. The World of a
+	 * stripe has this as its border and exchanges edge columns and buds with
+	 * both neighbours over unix sockets, see game::Border. Physics and sun
+	 * never cross columns, so they need nothing from neighbours.
+	 * Every stripe has its own generator seeded with the world's seed plus
+	 * its index, a single stripe wraps around by itself and ticks exactly
+	 * like World with the same seed.
+	 * Messages are framed with u32 size of the rest.
+	 */
+	class StripeWorld : public game::Border
+	{
+	public:
+		const int index;
+		const int stripes;
+		/* columns of this stripe */
+		const unsigned int x0, x1;
+
+		/**
+		 * @param params parameters of the whole world, its seed must be set
+		 * @param left @param right sockets connected to the neighbouring
+		 * stripes, -1 when there is only one stripe
+		 */
+		StripeWorld(unsigned int w, unsigned int h, const game::Parameters& params, int index, int stripes,
+					int left, int right);
+		StripeWorld(const StripeWorld&) = delete;
+		StripeWorld& operator=(const StripeWorld&) = delete;
+
+		/* spawn trees of the whole world which are in this stripe */
+		void spawn(const std::vector<RecordedSpawn>& spawns);
+		/**
+		 * @brief Advance by one year together with the other stripes.
+		 * @return false if there are no trees in this stripe
+		 * @throw std::runtime_error if a neighbour fails or sends a malformed message
+		 */
+		bool tick();
+		game::Statistics statistics() const { return game::gather_statistics(world); }
+		/* World::hash of this stripe */
+		std::uint64_t hash() const noexcept { return world.hash; }
+
+		void exchangeEdges(const game::World& world) override;
+		void exchangeBuds(const game::World& world) override;
+
+		/* first column of stripe @a i of @a n */
+		static unsigned int column(unsigned int w, int n, int i)
+		{
+			return static_cast<unsigned int>(std::uint64_t(w) * i / n);
+		}
+
+	private:
+		entt::registry registry;
+		game::World world;
+		/* sockets of the left and right neighbours */
+		int peers[2];
+
+		/* send out[side] to neighbour at side and receive a message from each into in */
+		void exchange(std::string (&out)[2], std::string (&in)[2]);
+	};
+}
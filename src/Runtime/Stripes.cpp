@@ -0,0 +1,285 @@
+#include "Stripes.hpp"
+#include "StripeWorld.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fmt/core.h>
+
+namespace runtime
+{
+	namespace
+	{
+		/* statistics of one stripe, sent to the parent process */
+		struct Report
+		{
+			std::int64_t tick = 0;
+			std::uint64_t trees = 0, seeds = 0, cells = 0;
+			std::int64_t energy = 0;
+			std::uint64_t hash = 0;
+		};
+
+		std::runtime_error system_error(const std::string& what)
+		{
+			return std::runtime_error(what + ": " + std::strerror(errno));
+		}
+
+		void write_all(int fd, const void* data, std::size_t size)
+		{
+			auto bytes = static_cast<const char*>(data);
+			while (size)
+			{
+				auto n = ::write(fd, bytes, size);
+				if (n < 0 && errno == EINTR)
+					continue;
+				if (n < 0)
+					throw system_error("Can't write report");
+				bytes += n;
+				size -= n;
+			}
+		}
+
+		/* false if the other end was closed before anything was read */
+		bool read_all(int fd, void* data, std::size_t size)
+		{
+			auto bytes = static_cast<char*>(data);
+			std::size_t done = 0;
+			while (done < size)
+			{
+				auto n = ::read(fd, bytes + done, size - done);
+				if (n < 0 && errno == EINTR)
+					continue;
+				if (n < 0)
+					throw system_error("Can't read report");
+				if (n == 0)
+				{
+					if (done == 0)
+						return false;
+					throw std::runtime_error("Report is truncated");
+				}
+				done += n;
+			}
+			return true;
+		}
+
+		void write_report(int fd, int tick, const StripeWorld& world)
+		{
+			auto stats = world.statistics();
+			Report r{tick, stats.trees, stats.seeds, stats.cells, stats.energy, world.hash()};
+			write_all(fd, &r, sizeof(r));
+		}
+
+		/* body of stripe's process, left and right are sockets connected to its neighbours */
+		void run_stripe(const StripeOptions& options, int index, const std::vector<RecordedSpawn>& spawns,
+						int left, int right, int reportFd)
+		{
+			StripeWorld world{options.w, options.h, options.params, index, options.stripes, left, right};
+			world.spawn(spawns);
+			write_report(reportFd, 0, world);
+			for (int tick = 1; options.ticks == 0 || tick <= options.ticks; tick++)
+			{
+				world.tick();
+				if (options.ticks == 0)
+				{
+					/* only the parent knows whether trees are left in other stripes */
+					write_report(reportFd, tick, world);
+					char more = 0;
+					if (!read_all(reportFd, &more, 1) || !more)
+						break;
+				}
+				else if (tick % options.statsEvery == 0 || tick == options.ticks)
+					write_report(reportFd, tick, world);
+			}
+		}
+	}
+
+	void run_stripes(const StripeOptions& options, const std::vector<RecordedSpawn>& spawns)
+	{
+		const int n = options.stripes;
+		if (n < 1 || options.w / n < 1)
+			throw std::invalid_argument(fmt::format("Can't split {} columns into {} stripes", options.w, n));
+		if (options.ticks < 0)
+			throw std::invalid_argument("Number of ticks can't be negative");
+		StripeOptions resolved = options;
+		if (resolved.params.seed == 0)
+			resolved.params.seed = std::random_device{}();
+		game::validate_parameters(resolved.params);
+
+		/* stripes hold their ends and the parent holds all of them until stripes start */
+		const rlim_t files = static_cast<rlim_t>(n) * 4 + 16;
+		rlimit limit;
+		if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < files)
+		{
+			limit.rlim_cur = std::min(files, limit.rlim_max);
+			::setrlimit(RLIMIT_NOFILE, &limit);
+			if (limit.rlim_cur < files)
+				throw std::invalid_argument(fmt::format("{} stripes need {} open files, only {} are allowed",
+														n, files, limit.rlim_cur));
+		}
+
+		std::FILE* out = stdout;
+		if (!options.csvPath.empty())
+		{
+			out = std::fopen(options.csvPath.c_str(), "w");
+			if (!out)
+				throw std::runtime_error("Can't open " + options.csvPath);
+		}
+
+		/* edges[i] connects right side of stripe i ([0]) with left side of the next one ([1]),
+		   the last stripe is connected with the first, a single stripe needs none */
+		std::vector<std::array<int, 2>> edges(n > 1 ? n : 0, {-1, -1});
+		/* reports of stripes ([1]), with ticks 0 the parent answers whether to go on */
+		std::vector<std::array<int, 2>> reports(n, {-1, -1});
+		std::vector<pid_t> pids;
+		auto closeAll = [&]() {
+			for (auto* fds : {&edges, &reports})
+				for (auto& pair : *fds)
+					for (int& fd : pair)
+						if (fd >= 0)
+						{
+							::close(fd);
+							fd = -1;
+						}
+		};
+		auto fail = [&](const std::string& what) {
+			auto error = system_error(what);
+			closeAll();
+			for (pid_t pid : pids)
+			{
+				::kill(pid, SIGTERM);
+				::waitpid(pid, nullptr, 0);
+			}
+			if (out != stdout)
+				std::fclose(out);
+			return error;
+		};
+		for (auto& edge : edges)
+			if (::socketpair(AF_UNIX, SOCK_STREAM, 0, edge.data()) < 0)
+				throw fail("Can't connect stripes");
+		for (auto& report : reports)
+			if (::socketpair(AF_UNIX, SOCK_STREAM, 0, report.data()) < 0)
+				throw fail("Can't create report socket");
+
+		using clock = std::chrono::steady_clock;
+		const auto start = clock::now();
+		std::fflush(nullptr);
+		for (int i = 0; i < n; i++)
+		{
+			pid_t pid = ::fork();
+			if (pid < 0)
+				throw fail("Can't start stripe");
+			if (pid == 0)
+			{
+				const int left = n > 1 ? edges[(i + n - 1) % n][1] : -1;
+				const int right = n > 1 ? edges[i][0] : -1;
+				/* others' ends must be closed for their exits to be noticed */
+				for (auto* pairs : {&edges, &reports})
+					for (auto& pair : *pairs)
+						for (int fd : pair)
+							if (fd >= 0 && fd != reports[i][1] && fd != left && fd != right)
+								::close(fd);
+				int code = 0;
+				try
+				{
+					run_stripe(resolved, i, spawns, left, right, reports[i][1]);
+				}
+				catch (const std::exception& e)
+				{
+					fmt::print(stderr, "Stripe {}: {}\n", i, e.what());
+					code = 1;
+				}
+				std::fflush(stderr);
+				::_exit(code);
+			}
+			pids.push_back(pid);
+		}
+		for (auto& pair : edges)
+			for (int& fd : pair)
+				if (fd >= 0)
+				{
+					::close(fd);
+					fd = -1;
+				}
+		for (int i = 0; i < n; i++)
+		{
+			::close(reports[i][1]);
+			reports[i][1] = -1;
+		}
+
+		fmt::print(out, "tick,trees,seeds,cells,energy,stripe_hash\n");
+		Report total;
+		bool complete = true, alive = true;
+		for (;;)
+		{
+			Report sum;
+			int got = 0;
+			for (int i = 0; i < n; i++)
+			{
+				Report r;
+				if (!read_all(reports[i][0], &r, sizeof(r)))
+					break;
+				got++;
+				sum.tick = r.tick;
+				sum.trees += r.trees;
+				sum.seeds += r.seeds;
+				sum.cells += r.cells;
+				sum.energy += r.energy;
+				sum.hash ^= r.hash;
+			}
+			if (got < n)
+			{
+				complete = got == 0;
+				break;
+			}
+			total = sum;
+			alive = sum.trees > 0;
+			if (options.ticks > 0 || sum.tick % options.statsEvery == 0 || !alive)
+				fmt::print(out, "{},{},{},{},{},{:016x}\n", sum.tick, sum.trees, sum.seeds, sum.cells, sum.energy, sum.hash);
+			if (options.ticks == 0 && sum.tick > 0)
+			{
+				const char more = alive;
+				for (int i = 0; i < n; i++)
+					if (::send(reports[i][0], &more, 1, MSG_NOSIGNAL) != 1)
+						complete = false;
+			}
+		}
+		for (int i = 0; i < n; i++)
+		{
+			::close(reports[i][0]);
+			reports[i][0] = -1;
+		}
+
+		int failed = -1;
+		for (int i = 0; i < n; i++)
+		{
+			int status = 0;
+			while (::waitpid(pids[i], &status, 0) < 0 && errno == EINTR)
+				;
+			if (failed < 0 && (!WIFEXITED(status) || WEXITSTATUS(status) != 0))
+				failed = i;
+		}
+		if (out != stdout)
+			std::fclose(out);
+		else
+			std::fflush(out);
+		if (failed >= 0 || !complete || (options.ticks > 0 && total.tick != options.ticks))
+			throw std::runtime_error(fmt::format("Stripe {} failed", std::max(failed, 0)));
+
+		const std::chrono::duration<double> elapsed = clock::now() - start;
+		fmt::print(stderr, "Simulated {} ticks in {:.2f}s ({:.0f} ticks/s) in {} stripes with seed {}{}, final stripe hash {:016x}.\n",
+				   total.tick, elapsed.count(), total.tick / std::max(elapsed.count(), 1e-9), n,
+				   resolved.params.seed, alive ? "" : ", all trees died", total.hash);
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Recording.hpp"
+#include "Game/World.hpp"
+
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+	struct StripeOptions
+	{
+		unsigned int w = 200;
+		unsigned int h = 50;
+		/* parameters of the whole world, stripe i is seeded with its seed plus i */
+		game::Parameters params;
+		/* number of stripes and processes */
+		int stripes = 2;
+		/* number of ticks to simulate, 0 means until extinction */
+		int ticks = 1000;
+		/* print statistics every n ticks */
+		int statsEvery = 100;
+		/* file to write statistics to in csv format, stdout if empty */
+		std::string csvPath;
+	};
+
+	/**
+	 * @brief Simulate a world split into vertical stripes, each of them in
+	 * its own process, print statistics of the whole world like run_headless().
+	 * @detail Neighbouring stripes are connected with unix sockets, every
+	 * stripe runs StripeWorld and they all tick at the same time. A tree
+	 * growing across an edge of a stripe buds a new tree in the neighbour,
+	 * so populations depend on the number of stripes, with one stripe they
+	 * are the ones run_headless() prints for the same seed. Instead of hash
+	 * the last column is stripe_hash, xor of World::hash of the stripes,
+	 * which equals World::hash only with one stripe. Until extinction the
+	 * parent process collects statistics of all stripes every tick and tells
+	 * them whether to go on.
+	 * @param spawns initial trees of the whole world
+	 * @throw std::invalid_argument if there are more stripes than columns or
+	 * open files they need, number of ticks is negative or parameters are
+	 * invalid
+	 * @throw std::runtime_error if csv file, sockets or processes can't be
+	 * created or a stripe failed
+	 */
+	void run_stripes(const StripeOptions& options, const std::vector<RecordedSpawn>& spawns);
+}
@@ -1,35 +1,62 @@
-
 #include "Game/World.hpp"
+#include "Game/Lineage.hpp"
+#include "Game/Memory.hpp"
 #include "Game/Serialization.hpp"
 #include "Game/Renderer.hpp"
+#include "Game/Trace.hpp"
 #include "Graphics/Widgets.hpp"
+#include "Runtime/Ensemble.hpp"
+#include "Runtime/EventWriter.hpp"
+#include "Runtime/Fitness.hpp"
+#include "Runtime/Headless.hpp"
+#include "Runtime/Metrics.hpp"
+#include "Runtime/Recording.hpp"
+#ifdef CURSED_TREES_LUA
+#include "Runtime/Script.hpp"
+#endif
+#include "Runtime/SharedFrames.hpp"
+#include "Runtime/Simulation.hpp"
+#include "Runtime/Stripes.hpp"
 
+#include <algorithm>
 #include <args.hxx>
+#include <chrono>
 #include <entt/entity/handle.hpp>
 #include <entt/entity/registry.hpp>
-#include <fstream>
+#include <future>
+#include <memory>
 #include <fmt/chrono.h>
 #include <fmt/ostream.h>
-#include <nlohmann/json.hpp>
-#include <thread>
-
-void dump_json(game::World& world)
-{
-	game::json json;
-	for (int i = 0; entt::entity entity : world.registry.view<game::Tree>())
-	{
-		json["tree" + std::to_string(i)] = game::serialize_tree(world, entity);
-		i++;
-	}
-	std::ofstream out("dump.json");
-	out << json.dump(2);
-}
+#include <vector>
+#include <unistd.h>
 
 enum class Mode {
 	IDLE,
 	TICK
 };
 
+/* world simulated on its own thread, the first one is the original world and the rest are its forks */
+struct Branch
+{
+	/* null for the original world */
+	std::unique_ptr<entt::registry> registry;
+	std::unique_ptr<game::World> world;
+	std::unique_ptr<runtime::Simulation> sim;
+	/* parameters changed from keyboard, every branch has its own */
+	game::Parameters params;
+	int reportedSkips = 0;
+};
+
+/* fork made on simulation thread of its parent */
+struct Fork
+{
+	game::World world;
+	/* time copying the world took, it grows with the number of trees and cells */
+	std::chrono::duration<double, std::milli> took;
+};
+
+constexpr std::size_t max_branches = 8;
+
 struct CursesDisplayer
 {
 	CursesDisplayer(graphics::Window& window)
@@ -58,18 +85,215 @@ struct CursesDisplayer
 		window.mvaddchar(y, x, ch);
 		window.off(colorPair);
 	}
-	std::function<void()> onScroll;
+	/* draw tiles rendered by simulation thread */
+	void show(const runtime::Snapshot& snapshot)
+	{
+		CURSED_TREES_TRACE("CursesDisplayer::show");
+		int w = snapshot.viewport.width, h = snapshot.viewport.height;
+		begin();
+		for (int y = 0; y < h; y++)
+			for (int x = 0; x < w; x++)
+			{
+				auto tile = snapshot.tiles[y * w + x];
+				draw(y, x, runtime::Snapshot::character(tile), runtime::Snapshot::color(tile));
+			}
+		end();
+	}
 };
 
+/* one line summary of a tick profile for the header */
+static std::string format_profile(const game::TickProfile& profile)
+{
+	using game::TickProfile;
+	using namespace std::chrono;
+	auto us = [&](TickProfile::Phase phase) {
+		return duration_cast<microseconds>(profile.time[phase]).count();
+	};
+	return fmt::format("Tick:[{}us] phys:{}/{} grow:{}/{} sun:{}/{} cells:+{} seeds:+{}-{}v{} nodes:+{}-{}",
+					   duration_cast<microseconds>(profile.total()).count(),
+					   us(TickProfile::PHYSICS), profile.entities[TickProfile::PHYSICS],
+					   us(TickProfile::GROW), profile.entities[TickProfile::GROW],
+					   us(TickProfile::SUN), profile.entities[TickProfile::SUN],
+					   profile.cellsGrown, profile.seedsSpawned, profile.seedsDestroyed, profile.seedsPlanted,
+					   profile.nodesAllocated, profile.nodesFreed);
+}
+
+/* one line summary of a memory report for the message line */
+static std::string format_memory(const game::MemoryReport& report)
+{
+	auto mib = [](std::size_t bytes) { return bytes / (1024.0 * 1024.0); };
+	std::string line = fmt::format("Memory: {:.1f}MiB reserved |", mib(report.total()));
+	for (auto& pool : report.pools)
+		line += fmt::format(" {} {}/{} {:.1f}/{:.1f}MiB |", pool.name, pool.size, pool.capacity,
+							mib(pool.liveBytes), mib(pool.reservedBytes));
+	line += fmt::format(" entities {} {:.1f}MiB, field {:.1f}MiB | {} list nodes {:.1f}MiB in {} pools {:.1f}MiB"
+						" | genomes {:.1f}MiB | RSS {:.1f}MiB, peak {:.1f}MiB",
+						report.entities, mib(report.entityBytes), mib(report.fieldBytes),
+						report.listNodes, mib(report.listNodeBytes), report.lists, mib(report.listPoolBytes),
+						mib(report.genomBytes), mib(report.rss), mib(report.peakRss));
+	return line;
+}
+
+/* history of population and trees' ages on the graph line */
+static void show_graph(graphics::Sparkline& graph, const runtime::Snapshot& snapshot)
+{
+	/* four sparklines with their labels, then the age histogram */
+	constexpr int label = 13;
+	const int ages = 6 + snapshot.ages.size();
+	const int column = std::max((graph.width() - ages) / 4, label + 1);
+	auto series = [&](auto value) {
+		std::vector<double> values;
+		for (auto& stats : snapshot.history)
+			values.push_back(value(stats));
+		return values;
+	};
+	auto last = snapshot.history.empty() ? game::Statistics{} : snapshot.history.back();
+	auto energy = [](const game::Statistics& stats) {
+		return stats.trees ? double(stats.energy) / stats.trees : 0.0;
+	};
+	graph.set(0, fmt::format("Live:[{:5}] ", last.living()),
+			  series([](const game::Statistics& stats) { return double(stats.living()); }), column - label);
+	graph.set(column, fmt::format("Cell:[{:5}] ", last.cells),
+			  series([](const game::Statistics& stats) { return double(stats.cells); }), column - label);
+	graph.set(column * 2, fmt::format("Enrg:[{:5.0f}] ", energy(last)), series(energy), column - label);
+	graph.set(column * 3, fmt::format("Spec:[{:5}] ", last.species),
+			  series([](const game::Statistics& stats) { return double(stats.species); }), column - label);
+	graph.setHistogram(column * 4, "Ages:", std::vector<double>(snapshot.ages.begin(), snapshot.ages.end()));
+}
+
 /// globals
 unsigned int worldW = 0, worldH = 0;
 bool running = true;
 Mode mode = Mode::IDLE;
-int numTicks = 0;
-int minSun = 5;
+game::Parameters params;
 bool energyMode = false;
+bool showProfile = false;
+/* where spans are written, empty when --trace isn't given */
+std::string tracePath;
+std::string recordPath;
+std::string replayPath;
+/* shared memory name frames are published to, empty when --publish isn't given */
+std::string publishName;
+/* where births and deaths are logged, empty when --lineage isn't given */
+std::string lineagePath;
+/* where tree events are written, empty when --events isn't given */
+std::string eventsPath;
+/* port of metrics endpoint on 127.0.0.1, 0 when --metrics-port isn't given */
+int metricsPort = 0;
+/* Lua script with hooks, empty when --script isn't given */
+std::string scriptPath;
+int ticksPerSecond = 5;
+int framesPerSecond = 30;
+bool headless = false;
+runtime::HeadlessOptions headlessOptions;
+bool ensemble = false;
+runtime::EnsembleOptions ensembleOptions;
+/* number of processes to split world between, 0 runs it in one */
+int stripes = 0;
+/* file ranked genomes are written to, empty when --evaluate isn't given */
+std::string evaluatePath;
+runtime::FitnessOptions fitnessOptions;
+/* file with genomes of initial trees or candidates of --evaluate, empty when --genomes isn't given */
+std::string genomesPath;
+/* genomes of initial trees, random ones are planted when it's empty */
+std::vector<game::Genom> initialGenomes;
 
 static int parseArguments(int argc, char** argv);
+static int run_terminal(std::chrono::high_resolution_clock::time_point start_time);
+
+/* write recorded spans, tell about it on stderr */
+static void write_trace(const std::string& filename)
+{
+	auto spans = game::trace::write(filename);
+	fmt::print(stderr, "Wrote {} spans to {}.\n", spans, filename);
+}
+
+/* where initial trees are planted */
+static std::vector<runtime::RecordedSpawn> initial_trees(unsigned int worldW)
+{
+	std::vector<runtime::RecordedSpawn> spawns;
+	for (unsigned int x = 10; x < worldW && x < 130; x += 10)
+		spawns.push_back({.x = x});
+	return spawns;
+}
+
+/* publisher of frames for cursed-trees-viewer if --publish is given */
+static std::unique_ptr<runtime::FramePublisher> make_publisher(const game::World& world)
+{
+	if (publishName.empty())
+		return nullptr;
+	return std::make_unique<runtime::FramePublisher>(publishName, world.w, world.h);
+}
+
+/* log of births and deaths if --lineage is given, attach it before planting initial trees */
+static std::unique_ptr<game::Lineage> make_lineage(game::World& world)
+{
+	if (lineagePath.empty())
+		return nullptr;
+	auto lineage = std::make_unique<game::Lineage>(lineagePath, world);
+	world.lineage = lineage.get();
+	return lineage;
+}
+
+/* tell how much the lineage log took */
+static void report_lineage(game::Lineage& lineage)
+{
+	lineage.flush();
+	fmt::print(stderr, "Wrote lineage of {} trees to {}, {:.1f} bytes per tree.\n", lineage.births(), lineagePath,
+			   lineage.births() ? double(lineage.bytes()) / lineage.births() : 0.0);
+}
+
+/* metrics endpoint if --metrics-port is given */
+static std::unique_ptr<runtime::MetricsServer> make_metrics()
+{
+	if (metricsPort == 0)
+		return nullptr;
+	return std::make_unique<runtime::MetricsServer>(static_cast<unsigned short>(metricsPort));
+}
+
+/* hooks of the script if --script is given */
+static std::unique_ptr<game::Hooks> make_script(game::World& world)
+{
+	if (scriptPath.empty())
+		return nullptr;
+#ifdef CURSED_TREES_LUA
+	auto script = std::make_unique<runtime::Script>(scriptPath);
+	world.hooks = script.get();
+	return script;
+#else
+	(void)world;
+	throw std::runtime_error("--script is unavailable, cursed-trees was configured with -DCURSED_TREES_LUA=OFF");
+#endif
+}
+
+/* writer of tree events if --events is given, attach it before planting initial trees */
+static std::unique_ptr<runtime::EventWriter> make_event_writer(game::World& world)
+{
+	if (eventsPath.empty())
+		return nullptr;
+	auto writer = std::make_unique<runtime::EventWriter>(eventsPath);
+	world.events = &writer->stream();
+	return writer;
+}
+
+/* tell how many events were written and lost */
+static void report_events(game::World& world, runtime::EventWriter& writer)
+{
+	world.events = nullptr;
+	writer.stop();
+	fmt::print(stderr, "Wrote {} events to {}, {} dropped.\n", writer.written(), eventsPath, writer.dropped());
+}
+
+/* plant initial trees, with genomes from --genomes in their order if it's given */
+static void populate(game::World& world)
+{
+	std::size_t i = 0;
+	for (auto& spawn : initial_trees(world.w))
+		if (initialGenomes.empty())
+			game::Tree::spawn(world, spawn.x, spawn.energy);
+		else
+			game::Tree::spawn(world, spawn.x, spawn.energy, initialGenomes[i++ % initialGenomes.size()]);
+}
 
 int main(int argc, char** argv)
 {
@@ -78,6 +302,163 @@ int main(int argc, char** argv)
 	using namespace std::chrono;
 	const auto start_time = high_resolution_clock::now();
 
+	if (worldW == 0) worldW = 200;
+	if (worldH == 0) worldH = 50;
+
+	if (!tracePath.empty())
+		game::trace::enable(true);
+
+	try
+	{
+		if (!genomesPath.empty())
+			(evaluatePath.empty() ? initialGenomes : fitnessOptions.genomes) = game::load_genomes(genomesPath);
+	}
+	catch (const std::exception& e)
+	{
+		fmt::print(stderr, "{}\n", e.what());
+		return 1;
+	}
+
+	if (!evaluatePath.empty())
+	{
+		fitnessOptions.h = worldH;
+		fitnessOptions.params = params;
+		fitnessOptions.outPath = evaluatePath;
+		try
+		{
+			runtime::evaluate_genomes(fitnessOptions);
+			if (!tracePath.empty())
+				write_trace(tracePath);
+		}
+		catch (const std::exception& e)
+		{
+			fmt::print(stderr, "{}\n", e.what());
+			return 1;
+		}
+		return 0;
+	}
+
+	if (ensemble)
+	{
+		ensembleOptions.w = worldW;
+		ensembleOptions.h = worldH;
+		ensembleOptions.params = params;
+		try
+		{
+			runtime::run_ensemble(ensembleOptions, populate);
+			if (!tracePath.empty())
+				write_trace(tracePath);
+		}
+		catch (const std::exception& e)
+		{
+			fmt::print(stderr, "{}\n", e.what());
+			return 1;
+		}
+		return 0;
+	}
+
+	if (stripes > 0)
+	{
+		runtime::StripeOptions options{.w = worldW, .h = worldH, .params = params, .stripes = stripes,
+									   .ticks = headlessOptions.ticks, .statsEvery = headlessOptions.statsEvery,
+									   .csvPath = headlessOptions.csvPath};
+		try
+		{
+			runtime::run_stripes(options, initial_trees(worldW));
+		}
+		catch (const std::exception& e)
+		{
+			fmt::print(stderr, "{}\n", e.what());
+			return 1;
+		}
+		return 0;
+	}
+
+	if (!replayPath.empty())
+	{
+		try
+		{
+			runtime::Replay replay{replayPath};
+			entt::registry registry;
+			game::World world{registry, replay.w, replay.h, replay.params};
+			auto lineage = make_lineage(world);
+			auto events = make_event_writer(world);
+			auto script = make_script(world);
+			replay.populate(world);
+			auto publisher = make_publisher(world);
+			auto metrics = make_metrics();
+			headlessOptions.replay = &replay;
+			headlessOptions.publisher = publisher.get();
+			headlessOptions.metrics = metrics.get();
+			game::trace::name_thread("replay");
+			runtime::run_headless(world, headlessOptions);
+			if (lineage)
+				report_lineage(*lineage);
+			if (events)
+				report_events(world, *events);
+			if (!tracePath.empty())
+				write_trace(tracePath);
+		}
+		catch (const std::exception& e)
+		{
+			fmt::print(stderr, "{}\n", e.what());
+			return 1;
+		}
+		return 0;
+	}
+
+	if (headless)
+	{
+		entt::registry registry;
+		game::World world{registry, worldW, worldH, params};
+		try
+		{
+			auto lineage = make_lineage(world);
+			auto events = make_event_writer(world);
+			auto script = make_script(world);
+			populate(world);
+			auto publisher = make_publisher(world);
+			auto metrics = make_metrics();
+			headlessOptions.publisher = publisher.get();
+			headlessOptions.metrics = metrics.get();
+			game::trace::name_thread("headless");
+			runtime::run_headless(world, headlessOptions);
+			if (lineage)
+				report_lineage(*lineage);
+			if (events)
+				report_events(world, *events);
+			if (!tracePath.empty())
+				write_trace(tracePath);
+		}
+		catch (const std::exception& e)
+		{
+			fmt::print(stderr, "{}\n", e.what());
+			return 1;
+		}
+		return 0;
+	}
+
+	try
+	{
+		return run_terminal(start_time);
+	}
+	catch (const std::exception& e)
+	{
+		/* whatever failed, the terminal must be usable again */
+		graphics::shutdown();
+		fmt::print(stderr, "{}\n", e.what());
+		return 1;
+	}
+}
+
+/* interactive session in terminal, started at @a start_time */
+static int run_terminal(std::chrono::high_resolution_clock::time_point start_time)
+{
+	using namespace std::chrono;
+	/* with --trace spans are recorded from the start, so they can be written any moment */
+	if (!tracePath.empty())
+		game::trace::enable(true);
+	game::trace::name_thread("ui");
 	graphics::init();
 	auto scr = graphics::stdscr();
 	scr.keypad(true);
@@ -88,12 +469,9 @@ int main(int argc, char** argv)
 	auto& header = gamescreen.header_line;
 	auto& endline = gamescreen.message_line;
 
-	if (worldW == 0) worldW = 200;
-	if (worldH == 0) worldH = 50;
-
 	entt::registry registry;
-	game::World world{registry, worldW, worldH};
-	game::Renderer renderer{world, CursesDisplayer{window}};
+	game::World world{registry, worldW, worldH, params};
+	CursesDisplayer display{window};
 
 	graphics::ColorPair black(graphics::Color::WHITE, graphics::Color::BLACK),
 		red(graphics::Color::WHITE, graphics::Color::RED), 
@@ -106,33 +484,105 @@ int main(int argc, char** argv)
 
 	header.on(white);
 	header.background(white);
-	header.properties[0] = "Press SPACE to begin";
+	header.set(0, "Press SPACE to begin");
 	endline.on(white);
 	endline.background(white);
 	endline.print("Hello world");
 
-	renderer.pBlackPair() = &black;
-	renderer.pRedPair() = &red;
-	renderer.pGreenPair() = &green;
-	renderer.pYellowPair() = &yellow;
-	renderer.pBluePair() = &blue;
-	renderer.pMagentaPair() = &magenta;
-	renderer.pCyanPair() = &cyan;
-	renderer.pWhitePair() = &white;
-	renderer.onScroll = [&]() { 
-		header.properties[30] = fmt::format("Position:[{:3}, {:3}]", renderer.x, renderer.y);
+	display.pBlackPair() = &black;
+	display.pRedPair() = &red;
+	display.pGreenPair() = &green;
+	display.pYellowPair() = &yellow;
+	display.pBluePair() = &blue;
+	display.pMagentaPair() = &magenta;
+	display.pCyanPair() = &cyan;
+	display.pWhitePair() = &white;
+
+	std::unique_ptr<runtime::Recorder> recorder;
+	std::unique_ptr<runtime::FramePublisher> publisher;
+	std::unique_ptr<game::Lineage> lineage;
+	std::unique_ptr<runtime::EventWriter> events;
+	std::unique_ptr<runtime::MetricsServer> metrics;
+	std::unique_ptr<game::Hooks> script;
+	try
+	{
+		if (!recordPath.empty())
+			recorder = std::make_unique<runtime::Recorder>(recordPath, world, initial_trees(world.w));
+		publisher = make_publisher(world);
+		lineage = make_lineage(world);
+		events = make_event_writer(world);
+		metrics = make_metrics();
+		script = make_script(world);
+	}
+	catch (const std::exception& e)
+	{
+		graphics::shutdown();
+		fmt::print(stderr, "{}\n", e.what());
+		return 1;
+	}
+	populate(world);
+
+	/* only the original world is recorded and published */
+	std::vector<Branch> branches;
+	branches.push_back({nullptr, nullptr,
+						std::make_unique<runtime::Simulation>(world, runtime::Simulation::Settings{
+								.paused = true,
+								.ticksPerSecond = ticksPerSecond,
+								.recorder = recorder.get(),
+								.publisher = publisher.get(),
+								.metrics = metrics.get()}),
+						world.params});
+	std::size_t current = 0;
+	runtime::Simulation* sim = branches[current].sim.get();
+	/* fork being made on simulation thread of its parent */
+	std::unique_ptr<entt::registry> forkRegistry;
+	std::future<Fork> fork;
+	auto showBranch = [&]() {
+		if (branches.size() > 1)
+			header.set(108, "Branch:[{}/{}]", current + 1, branches.size());
+	};
+	runtime::Viewport view{.width = window.width(), .height = window.height()};
+	auto maxX = [&]() { return int(world.w) - view.width; };
+	auto maxY = [&]() { return int(world.h) - view.height; };
+	auto scroll = [&](int offsetX, int offsetY) {
+		view.x = std::min(std::max(0, view.x + offsetX), maxX());
+		view.y = std::min(std::max(0, view.y + offsetY), maxY());
+		if (!showProfile)
+			header.set(30, "Position:[{:3}, {:3}]", view.x, view.y);
+		sim->setViewport(view);
 	};
-	renderer.scroll(0, 0); /* show 'position' property by calling onScroll */
+	scroll(0, 0); /* show 'position' property */
+	sim->start();
 
-	for (int i = 1; i < 13; i++)
-		game::Tree::spawn(world, i * 10);
+	using clock = steady_clock;
+	auto nextFrame = clock::now();
+	runtime::RateCounter fps;
+	runtime::Snapshot snapshot;
+	int frameNo = 0;
+	/* memory report requested from simulation thread */
+	std::future<game::MemoryReport> memoryReport;
+	bool redraw = true;
+	/* error which stopped a simulation, e.g. of a failing script */
+	std::string failure;
 
 	while(running)
 	{
-		milliseconds wait_time{200};
-		if (auto key = scr.getkey())
+		try
+		{
+			for (auto& branch : branches)
+				branch.sim->rethrow();
+		}
+		catch (const std::exception& e)
+		{
+			failure = e.what();
+			break;
+		}
+		const auto framePeriod = duration_cast<clock::duration>(seconds{1}) / framesPerSecond;
+
+		while (auto key = scr.getkey())
 		{
-			wait_time = milliseconds{15}; /* sleep less when user pressed a key */
+			CURSED_TREES_TRACE("input");
+			redraw = true;
 			switch(*key)
 			{
 			case graphics::Key::q:
@@ -140,6 +590,9 @@ int main(int argc, char** argv)
 				break;
 			case graphics::Key::RESIZE:
 				gamescreen.resize();
+				view.width = window.width();
+				view.height = window.height();
+				scroll(0, 0);
 				break;
 			case graphics::Key::SPACE:
 				switch(mode)
@@ -147,117 +600,329 @@ int main(int argc, char** argv)
 					case Mode::IDLE: mode = Mode::TICK; break;
 					case Mode::TICK: mode = Mode::IDLE; break;
 				}
+				for (auto& branch : branches)
+					branch.sim->pause(mode == Mode::IDLE);
 				break;
 			case graphics::Key::D:
-				dump_json(world);
+				sim->post([](game::World& world) { game::dump_json(world); });
 				endline.print("Dumped world to dump.json");
 				break;
+			case graphics::Key::m:
+			{
+				auto promise = std::make_shared<std::promise<game::MemoryReport>>();
+				memoryReport = promise->get_future();
+				sim->post([promise](game::World& world) { promise->set_value(game::memory_report(world)); });
+				break;
+			}
+			case graphics::Key::t:
+			{
+				if (tracePath.empty())
+				{
+					endline.print("Nothing is traced, start with --trace file.");
+					break;
+				}
+				try
+				{
+					auto spans = game::trace::write(tracePath);
+					endline.print("Wrote {} spans to {}.", spans, tracePath);
+				}
+				catch (const std::exception& e)
+				{
+					endline.print("{}", e.what());
+				}
+				break;
+			}
 			case graphics::Key::e:
-				energyMode = !energyMode;
-				if (energyMode) endline.print("Energy mode enabled.");
+				view.energyMode = !view.energyMode;
+				sim->setViewport(view);
+				if (view.energyMode) endline.print("Energy mode enabled.");
 				else endline.print("Energy mode disabled.");
 				break;
 			case graphics::Key::s:
-				for (int i = 0; i < 100; i++)
+				for (auto& branch : branches)
+					branch.sim->fastForward(100);
+				break;
+			case graphics::Key::S:
+				for (auto& branch : branches)
+					branch.sim->fastForward(1000);
+				break;
+			case graphics::Key::c:
+				for (auto& branch : branches)
+					branch.sim->cancel();
+				break;
+			case graphics::Key::f:
+			{
+				if (fork.valid())
+					break;
+				if (branches.size() == max_branches)
 				{
-					world.tick(minSun, 3);
-					numTicks++;
+					endline.print("Can't have more than {} branches.", max_branches);
+					break;
 				}
-				endline.print("Skipped 100 years.");
+				forkRegistry = std::make_unique<entt::registry>();
+				auto promise = std::make_shared<std::promise<Fork>>();
+				fork = promise->get_future();
+				sim->post([promise, target = forkRegistry.get()](game::World& world) {
+					try
+					{
+						const auto start = steady_clock::now();
+						auto forked = world.fork(*target);
+						promise->set_value(Fork{std::move(forked), steady_clock::now() - start});
+					}
+					catch (...)
+					{
+						promise->set_exception(std::current_exception());
+					}
+				});
 				break;
-			case graphics::Key::S:
-				endline.print("Please, wait...");
-				endline.draw();
-				for (int i = 0; i < 1000; i++)
+			}
+			case graphics::Key::b:
+				if (branches.size() == 1)
+				{
+					endline.print("There are no branches, press 'f' to fork the world.");
+					break;
+				}
+				current = (current + 1) % branches.size();
+				sim = branches[current].sim.get();
+				sim->setViewport(view);
+				showBranch();
+				endline.print("Switched to branch {}, sun's energy is {}, mutation chance is {:.2f}.", current + 1,
+							  branches[current].params.minSun, branches[current].params.mutationChance);
+				break;
+			case graphics::Key::g:
+				gamescreen.showGraph(!gamescreen.graphShown());
+				view.height = window.height();
+				scroll(0, 0);
+				if (gamescreen.graphShown())
+					show_graph(gamescreen.graph_line, snapshot);
+				break;
+			case graphics::Key::p:
+				if (!game::profiling_enabled)
 				{
-					world.tick(minSun, 3);
-					numTicks++;
+					endline.print("Tick profiler is compiled out, rebuild with -DCURSED_TREES_PROFILE=ON.");
+					break;
 				}
-				endline.print("Skipped 1000 years.");
+				/* profile takes place of position, TPS, FPS and hash */
+				showProfile = !showProfile;
+				header.remove(30);
+				header.remove(52);
+				header.remove(68);
+				header.remove(84);
+				if (showProfile)
+					header.set(30, format_profile(snapshot.profile));
+				else
+					scroll(0, 0);
 				break;
 			case graphics::Key::i:
 			case graphics::Key::UP:
-				if (renderer.y == renderer.maxY()) 
+				if (view.y == maxY()) 
 				{
 					endline.print("Top of world.");
 					graphics::beep();
 				}
-				renderer.scroll(0, 1);
+				scroll(0, 1);
 				break;
 			case graphics::Key::k:
 			case graphics::Key::DOWN:
-				if (renderer.y == renderer.minY()) 
+				if (view.y == 0) 
 				{
 					endline.print("Bottom of world.");
 					graphics::beep();
 				}
-				renderer.scroll(0, -1);
+				scroll(0, -1);
 				break;
 			case graphics::Key::j:
 			case graphics::Key::LEFT:
-				if (renderer.x == renderer.minX()) 
+				if (view.x == 0) 
 				{
 					endline.print("Beginning of world.");
 					graphics::beep();
 				}
-				renderer.scroll(-1, 0);
+				scroll(-1, 0);
 				break;
 			case graphics::Key::l:
 			case graphics::Key::RIGHT:
-				if (renderer.x == renderer.maxX())
+				if (view.x == maxX())
 				{
 					endline.print("End of world.");
 					graphics::beep();
 				}
-				renderer.scroll(1, 0);
+				scroll(1, 0);
 				break;
 			case graphics::Key::u:
-				if (renderer.x < 10) 
+				if (view.x < 10) 
 				{
 					endline.print("Beginning of world.");
 					graphics::beep();
 				}
-				renderer.scroll(-10, 0);
+				scroll(-10, 0);
 				break;
 			case graphics::Key::o:
-				if (renderer.x > renderer.maxX()-10) 
+				if (view.x > maxX()-10) 
 				{
 					endline.print("End of world.");
 					graphics::beep();
 				}
-				renderer.scroll(10, 0);
+				scroll(10, 0);
 					break;
 			case graphics::Key::PLUS:
-				minSun++;
-				endline.print("Sun's energy is now {}.", minSun);
+				branches[current].params.minSun++;
+				sim->setMinSun(branches[current].params.minSun);
+				endline.print("Sun's energy is now {}.", branches[current].params.minSun);
 				break;
 			case graphics::Key::MINUS:
-				minSun--;
-				endline.print("Sun's energy is now {}.", minSun);
+				branches[current].params.minSun--;
+				sim->setMinSun(branches[current].params.minSun);
+				endline.print("Sun's energy is now {}.", branches[current].params.minSun);
+				break;
+			case graphics::Key::LESS:
+			case graphics::Key::GREATER:
+			{
+				auto& chance = branches[current].params.mutationChance;
+				const int percent = static_cast<int>(chance * 100 + 0.5f) + (*key == graphics::Key::LESS ? -5 : 5);
+				chance = std::clamp(percent, 0, 100) / 100.0f;
+				sim->setMutationChance(chance);
+				endline.print("Mutation chance is now {:.2f}.", chance);
+				break;
+			}
+			case graphics::Key::LEFT_BRACKET:
+				ticksPerSecond = std::max(ticksPerSecond / 2, 1);
+				for (auto& branch : branches)
+					branch.sim->setTicksPerSecond(ticksPerSecond);
+				endline.print("Simulation speed is now {} ticks per second.", ticksPerSecond);
+				break;
+			case graphics::Key::RIGHT_BRACKET:
+				ticksPerSecond = std::min(ticksPerSecond * 2, 10000);
+				for (auto& branch : branches)
+					branch.sim->setTicksPerSecond(ticksPerSecond);
+				endline.print("Simulation speed is now {} ticks per second.", ticksPerSecond);
 				break;
 			default:
 				break;
 			}
 		}
 
-		if (mode == Mode::TICK)
+		auto now = clock::now();
+		if (redraw && now >= nextFrame)
 		{
-			header.properties[0] = fmt::format("Trees:[{:4}]", registry.size<game::Tree>());
-			header.properties[15] = fmt::format("Year:[{:5}]", numTicks++);
-			if (!world.tick(minSun, 3))
+			CURSED_TREES_TRACE("frame");
+			const bool wasAlive = snapshot.alive;
+			if (sim->acquire(snapshot))
 			{
-				endline.on(magenta);
-				endline.print("No life");
+				if (mode == Mode::TICK || snapshot.skips)
+				{
+					header.set(0, "Trees:[{:4}]", snapshot.trees);
+					header.set(15, "Year:[{:5}]", snapshot.year);
+					if (!showProfile)
+						header.set(84, "Hash:[{:016x}]", snapshot.hash);
+				}
+				if (gamescreen.graphShown())
+					show_graph(gamescreen.graph_line, snapshot);
+				if (showProfile)
+					header.set(30, format_profile(snapshot.profile));
+				else
+					header.set(52, "TPS:[{:4}/{:4}]", snapshot.ticksPerSecond, ticksPerSecond);
+				if (wasAlive && !snapshot.alive)
+				{
+					endline.on(magenta);
+					endline.print("No life");
+				}
+				if (snapshot.skipping)
+					endline.print("Skipping years: {}/{}, press 'c' to cancel.",
+								  snapshot.skipDone, snapshot.skipTotal);
+				else if (snapshot.skips != branches[current].reportedSkips)
+				{
+					branches[current].reportedSkips = snapshot.skips;
+					if (snapshot.skipCancelled)
+						endline.print("Cancelled, skipped {} of {} years.", snapshot.skipDone, snapshot.skipTotal);
+					else
+						endline.print("Skipped {} years.", snapshot.skipDone);
+				}
+				display.show(snapshot);
+			}
+			if (memoryReport.valid() && memoryReport.wait_for(seconds{0}) == std::future_status::ready)
+				endline.print(format_memory(memoryReport.get()));
+			if (fork.valid() && fork.wait_for(seconds{0}) == std::future_status::ready)
+			{
+				try
+				{
+					auto [forkedWorld, took] = fork.get();
+					auto forked = std::make_unique<game::World>(std::move(forkedWorld));
+					const unsigned int year = forked->year;
+					auto branchSim = std::make_unique<runtime::Simulation>(*forked, runtime::Simulation::Settings{
+							.paused = mode == Mode::IDLE,
+							.ticksPerSecond = ticksPerSecond});
+					/* a new simulation reports no skips */
+					branches.push_back({std::move(forkRegistry), std::move(forked), std::move(branchSim),
+										branches[current].params, 0});
+					current = branches.size() - 1;
+					sim = branches[current].sim.get();
+					sim->setViewport(view);
+					sim->start();
+					showBranch();
+					endline.print("Forked branch {} at year {} in {:.1f} ms, press 'b' to switch between branches.",
+								  current + 1, year, took.count());
+				}
+				catch (const std::exception& e)
+				{
+					forkRegistry.reset();
+					endline.print("{}", e.what());
+				}
 			}
+			if (!showProfile)
+				header.set(68, "FPS:[{:3}/{:3}]", fps.rate, framesPerSecond);
+			if (snapshot.skipping)
+			{
+				endline.draw();
+				graphics::status_load(endline, 0, endline.width() - 5, frameNo);
+				endline.stage();
+			}
+			{
+				CURSED_TREES_TRACE("Screen::draw");
+				gamescreen.draw();
+			}
+			fps.add();
+			frameNo++;
+			nextFrame += framePeriod;
+			if (nextFrame <= now) /* rendering fell behind, skip missed frames */
+				nextFrame = now + framePeriod;
+			/* keep animations going, otherwise wait for input or a new snapshot */
+			redraw = snapshot.skipping || endline.animated();
 		}
+		fps.update(now);
 
-		renderer.render(energyMode);
-		gamescreen.draw();
-		std::this_thread::sleep_for(wait_time);
+		/* block until a key is pressed or simulation publishes a snapshot,
+		 * if a frame is waiting to be drawn sleep only until it's due */
+		auto timeout = milliseconds{-1};
+		if (redraw)
+			timeout = std::max(ceil<milliseconds>(nextFrame - clock::now()), milliseconds{0});
+		if (runtime::wait({STDIN_FILENO, sim->published().handle()}, timeout) & 2)
+		{
+			sim->published().consume();
+			redraw = true;
+		}
 	}
 
+	for (auto& branch : branches)
+		branch.sim->stop();
 	endline.print("Ended in {}.", duration_cast<seconds>(high_resolution_clock::now() - start_time));
+	if (!tracePath.empty())
+	{
+		try
+		{
+			auto spans = game::trace::write(tracePath);
+			endline.print("Ended in {}, wrote {} spans to {}.",
+						  duration_cast<seconds>(high_resolution_clock::now() - start_time), spans, tracePath);
+		}
+		catch (const std::exception& e)
+		{
+			endline.print("{}", e.what());
+		}
+	}
+	if (!failure.empty())
+		endline.print("{}", failure);
 	endline.draw(red);
+	graphics::update();
 
 	scr.nodelay(false);
 	scr.getkey();
@@ -282,14 +947,54 @@ static int parseArguments(int argc, char** argv)
 		"   [o]: scroll screen right by 10 chars\n"
         "   [-]: reduce sun's energy by 1\n"
         "   [+]: increase sun's energy by 1\n"
+        "   [<]: reduce mutation chance by 0.05\n"
+        "   [>]: increase mutation chance by 0.05\n"
         "   [s]: skip 100 years\n"
-        "   [S]: skip 1000 years", 
+        "   [S]: skip 1000 years\n"
+        "   [c]: cancel skipping years\n"
+        "   [p]: toggle tick profiler\n"
+        "   [m]: show memory report\n"
+        "   [g]: toggle population graphs and histogram of trees' ages\n"
+        "   [f]: fork world into a branch simulated side by side\n"
+        "   [b]: switch to next branch, [-], [+], [<] and [>] change only current one\n"
+        "   [t]: write trace of recent frames and ticks to --trace file\n"
+        "   [[]: halve simulation speed\n"
+        "   []]: double simulation speed", 
 		"If you encounter any bug please add issue to the github repo: https://github.com/LLLida/cursed-trees\n"
 		"or leave me email: 0adilmohammad0@gmail.com.");
 	args::HelpFlag help(parser, "help", "Display this help menu", {'h', "help"});
 	args::CompletionFlag completion(parser, {"complete"});
 	args::Flag printVersion(parser, "version", "Display version message", {'v', "version"});
 	args::ValueFlag<int> minSunFlag(parser, "0..20", "Set minimal sun energy", {"min-sun"});
+	args::ValueFlag<unsigned int> seedFlag(parser, "number", "Seed of world's random generator", {"seed"});
+	args::ValueFlagList<std::string> paramFlag(parser, "name=value", "Set world parameter: min-sun, sun-levels, upkeep, energy-scale, mutation-chance, min-age or max-age", {"param"});
+	args::ValueFlag<int> tpsFlag(parser, "1..10000", "Set target simulation speed in ticks per second", {"tps"});
+	args::ValueFlag<int> fpsFlag(parser, "1..240", "Set target frame rate", {"fps"});
+	args::Flag headlessFlag(parser, "headless", "Run without terminal, print statistics in csv format", {"headless"});
+	args::ValueFlag<int> ticksFlag(parser, "number of ticks", "Stop headless or ensemble runs after this many ticks, 0 runs until all trees die", {"ticks"});
+	args::ValueFlag<int> statsEveryFlag(parser, "number of ticks", "Print statistics every n ticks in headless run", {"stats-every"});
+	args::ValueFlag<std::string> csvFlag(parser, "file", "Write headless statistics to file instead of stdout, or results of every ensemble run", {"csv"});
+	args::ValueFlag<std::string> profileFlag(parser, "file", "Write timings and counters of every tick to file in csv format in headless run", {"profile"});
+	args::ValueFlag<std::string> traceFlag(parser, "file", "Record simulation and rendering spans, write them to file in Chrome trace format at exit", {"trace"});
+	args::ValueFlag<std::string> memoryFlag(parser, "file", "Write memory report to file in csv format with statistics in headless run", {"memory"});
+	args::ValueFlag<std::string> recordFlag(parser, "file", "Record seed, parameters and inputs of terminal session to file", {"record"});
+	args::ValueFlag<std::string> publishFlag(parser, "name", "Publish frames to shared memory object name (e.g. /cursed-trees) for cursed-trees-viewer", {"publish"});
+	args::ValueFlag<std::string> lineageFlag(parser, "file", "Log every tree's birth, planting and death to file for cursed-trees-lineage", {"lineage"});
+	args::ValueFlag<std::string> eventsFlag(parser, "file", "Write spawns, plantings, growth, deaths and mutations of trees to file, as json lines if it ends with .ndjson", {"events"});
+	args::ValueFlag<int> metricsPortFlag(parser, "port", "Serve Prometheus metrics at http://127.0.0.1:port/metrics and trees at /tree?x=X&y=Y", {"metrics-port"});
+	args::ValueFlag<std::string> scriptFlag(parser, "file", "Lua script with sun, spawn and tick_end hooks called every tick", {"script"});
+	args::ValueFlag<std::string> replayFlag(parser, "file", "Replay recorded session without terminal as fast as possible", {"replay"});
+	args::ValueFlagList<int> dumpAtFlag(parser, "tick", "Dump world to dump-<tick>.json at this tick in headless run", {"dump-at"});
+	args::Flag ensembleFlag(parser, "ensemble", "Run many worlds in parallel without terminal, print aggregated results in csv format", {"ensemble"});
+	args::ValueFlagList<std::string> sweepFlag(parser, "name=v1,v2,...", "Run ensemble for each of these parameter values", {"sweep"});
+	args::ValueFlag<int> runsFlag(parser, "number", "Number of ensemble runs with different seeds for every parameter combination, or worlds every genom is planted in with --evaluate", {"runs"});
+	args::ValueFlag<unsigned int> jobsFlag(parser, "number", "Number of ensemble or --evaluate worker threads, one per core by default", {"jobs"});
+	args::ValueFlag<std::string> evaluateFlag(parser, "file", "Plant genomes in small worlds in parallel for a whole lifetime, write them to file ranked by seeds, energy and height", {"evaluate"});
+	args::ValueFlag<std::string> genomesFlag(parser, "file", "Genomes of initial trees from a dump or --evaluate ranking, or candidates for --evaluate", {"genomes"});
+	args::ValueFlag<int> candidatesFlag(parser, "number", "Number of random genomes --evaluate ranks when --genomes isn't given", {"candidates"});
+	args::ValueFlag<int> groupFlag(parser, "number", "Number of trees --evaluate plants together in a world", {"group"});
+	args::ValueFlag<unsigned int> spacingFlag(parser, "number", "Width of world per tree in --evaluate", {"spacing"});
+	args::ValueFlag<int> stripesFlag(parser, "number", "Run without terminal like --headless with world split into this many vertical stripes, each simulated by its own process", {"stripes"});
 	args::ValueFlag<unsigned int> worldWFlag(parser, "number of chars", "world's width", {'w', "width"});
 	args::ValueFlag<unsigned int> worldHFlag(parser, "number of chars", "world's height", {'w', "height"});
 	try
@@ -336,7 +1041,74 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 )", __DATE__);
 		return 1;
 	}
-	if (minSunFlag) minSun = args::get(minSunFlag);
+	try
+	{
+		for (auto& param : args::get(paramFlag))
+		{
+			auto eq = param.find('=');
+			if (eq == std::string::npos)
+				throw std::invalid_argument("Parameter must look like name=value: " + param);
+			runtime::set_parameter(params, param.substr(0, eq), param.substr(eq + 1));
+		}
+	}
+	catch (const std::invalid_argument& e)
+	{
+		fmt::print("{}\n", e.what());
+		return 1;
+	}
+	if (minSunFlag) params.minSun = args::get(minSunFlag);
+	if (seedFlag) params.seed = args::get(seedFlag);
+	try
+	{
+		game::validate_parameters(params);
+	}
+	catch (const std::invalid_argument& e)
+	{
+		fmt::print("{}\n", e.what());
+		return 1;
+	}
+	if (tpsFlag) ticksPerSecond = std::clamp(args::get(tpsFlag), 1, 10000);
+	if (fpsFlag) framesPerSecond = std::clamp(args::get(fpsFlag), 1, 240);
+	if (headlessFlag) headless = true;
+	if (ticksFlag) headlessOptions.ticks = std::max(args::get(ticksFlag), 0);
+	if (statsEveryFlag) headlessOptions.statsEvery = std::max(args::get(statsEveryFlag), 1);
+	if (csvFlag) headlessOptions.csvPath = args::get(csvFlag);
+	if (dumpAtFlag) headlessOptions.dumpAt = args::get(dumpAtFlag);
+	if (profileFlag) headlessOptions.profilePath = args::get(profileFlag);
+	if (traceFlag) tracePath = args::get(traceFlag);
+	if (memoryFlag) headlessOptions.memoryPath = args::get(memoryFlag);
+	if (recordFlag) recordPath = args::get(recordFlag);
+	if (replayFlag) replayPath = args::get(replayFlag);
+	if (publishFlag) publishName = args::get(publishFlag);
+	if (lineageFlag) lineagePath = args::get(lineageFlag);
+	if (eventsFlag) eventsPath = args::get(eventsFlag);
+	if (metricsPortFlag) metricsPort = std::clamp(args::get(metricsPortFlag), 0, 65535);
+	if (scriptFlag) scriptPath = args::get(scriptFlag);
+	if (ensembleFlag) ensemble = true;
+	if (sweepFlag) ensembleOptions.sweeps = args::get(sweepFlag);
+	if (runsFlag) ensembleOptions.runs = std::max(args::get(runsFlag), 1);
+	if (jobsFlag) ensembleOptions.jobs = args::get(jobsFlag);
+	if (evaluateFlag) evaluatePath = args::get(evaluateFlag);
+	if (genomesFlag) genomesPath = args::get(genomesFlag);
+	if (candidatesFlag) fitnessOptions.candidates = std::max(args::get(candidatesFlag), 1);
+	if (groupFlag) fitnessOptions.group = std::max(args::get(groupFlag), 1);
+	if (spacingFlag) fitnessOptions.spacing = std::max(args::get(spacingFlag), 1u);
+	if (runsFlag) fitnessOptions.trials = ensembleOptions.runs;
+	if (jobsFlag) fitnessOptions.jobs = ensembleOptions.jobs;
+	if (genomesFlag && !evaluateFlag && (recordFlag || replayFlag || stripesFlag))
+	{
+		fmt::print("--genomes can't be used with --record, --replay or --stripes, they plant random trees\n");
+		return 1;
+	}
+	if (stripesFlag && (lineageFlag || eventsFlag || metricsPortFlag || scriptFlag))
+	{
+		fmt::print("--lineage, --events, --metrics-port and --script can't be used with --stripes, "
+				   "every stripe is a world of its own\n");
+		return 1;
+	}
+	if (ticksFlag) ensembleOptions.ticks = headlessOptions.ticks;
+	if (csvFlag) ensembleOptions.csvPath = headlessOptions.csvPath;
+	if (stripesFlag) stripes = std::max(args::get(stripesFlag), 1);
 	if (worldWFlag) worldW = args::get(worldWFlag);
 	if (worldHFlag) worldH = args::get(worldHFlag);
 	return 0;
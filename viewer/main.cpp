@@ -0,0 +1,154 @@
+
+#include "Graphics/Widgets.hpp"
+#include "Runtime/Events.hpp"
+#include "Runtime/SharedFrames.hpp"
+#include "Runtime/Simulation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <fmt/core.h>
+
+/* watch frames which `cursed-trees --publish name` publishes, attach and detach at any moment */
+int main(int argc, char** argv)
+{
+	using namespace std::chrono;
+	if (argc > 1 && (std::string_view(argv[1]) == "-h" || std::string_view(argv[1]) == "--help"))
+	{
+		fmt::print("usage: {} [name]\n"
+				   "Watch a simulation started with --publish name, /cursed-trees by default.\n"
+				   "   [q]: quit the viewer, simulation goes on\n"
+				   "   [<arrows>, i, j, k, l]: scroll screen by 1 char\n"
+				   "   [u, o]: scroll screen left, right by 10 chars\n", argv[0]);
+		return 0;
+	}
+	const std::string name = argc > 1 ? argv[1] : "/cursed-trees";
+
+	graphics::init();
+	auto scr = graphics::stdscr();
+	scr.keypad(true);
+	scr.nodelay(true);
+
+	graphics::Screen screen;
+	auto& window = screen.surface;
+	auto& header = screen.header_line;
+	auto& endline = screen.message_line;
+
+	graphics::ColorPair colors[] = {
+		{graphics::Color::WHITE, graphics::Color::BLACK},
+		{graphics::Color::WHITE, graphics::Color::RED},
+		{graphics::Color::WHITE, graphics::Color::GREEN},
+		{graphics::Color::WHITE, graphics::Color::YELLOW},
+		{graphics::Color::WHITE, graphics::Color::BLUE},
+		{graphics::Color::WHITE, graphics::Color::MAGENTA},
+		{graphics::Color::WHITE, graphics::Color::CYAN},
+		{graphics::Color::BLACK, graphics::Color::WHITE},
+	};
+	auto& white = colors[7];
+	header.on(white);
+	header.background(white);
+	endline.on(white);
+	endline.background(white);
+
+	std::unique_ptr<runtime::FrameReader> reader;
+	std::uint64_t lastFrame = 0;
+	/* x from the left, y from the bottom of world like in cursed-trees */
+	int viewX = 0, viewY = 0;
+	auto nextAttach = steady_clock::now();
+	bool running = true, moved = true;
+	endline.print("Waiting for frames at {}, press 'q' to quit.", name);
+
+	while (running)
+	{
+		while (auto key = scr.getkey())
+		{
+			switch (*key)
+			{
+			case graphics::Key::q: running = false; break;
+			case graphics::Key::RESIZE: screen.resize(); break;
+			case graphics::Key::i: case graphics::Key::UP: viewY++; break;
+			case graphics::Key::k: case graphics::Key::DOWN: viewY--; break;
+			case graphics::Key::j: case graphics::Key::LEFT: viewX--; break;
+			case graphics::Key::l: case graphics::Key::RIGHT: viewX++; break;
+			case graphics::Key::u: viewX -= 10; break;
+			case graphics::Key::o: viewX += 10; break;
+			default: break;
+			}
+			moved = true;
+		}
+
+		if (reader && reader->closed())
+		{
+			reader.reset();
+			endline.print("Simulation at {} stopped, waiting for the next one.", name);
+		}
+		if (!reader && steady_clock::now() >= nextAttach)
+		{
+			nextAttach = steady_clock::now() + milliseconds{500};
+			try
+			{
+				reader = std::make_unique<runtime::FrameReader>(name);
+				if (reader->closed())
+					reader.reset();
+				else
+				{
+					lastFrame = 0;
+					endline.print("Attached to {}, world is {}x{}.", name, reader->width(), reader->height());
+				}
+			}
+			catch (const std::runtime_error&)
+			{
+				/* nothing is published yet */
+			}
+		}
+
+		if (reader)
+		{
+			const int worldW = reader->width(), worldH = reader->height();
+			const int w = std::min(window.width(), worldW), h = std::min(window.height(), worldH);
+			viewX = std::clamp(viewX, 0, worldW - w);
+			viewY = std::clamp(viewY, 0, worldH - h);
+			/* a frame overwritten while it was drawn is dropped and the next one is taken */
+			for (int attempt = 0; attempt < 3; attempt++)
+			{
+				/* draw the last frame again if the view moved */
+				auto frame = reader->latest(moved && lastFrame ? lastFrame - 1 : lastFrame);
+				if (!frame.info)
+					break;
+				window.erase();
+				const int top = worldH - viewY - h;
+				for (int y = 0; y < h; y++)
+					for (int x = 0; x < w; x++)
+					{
+						auto tile = frame.tiles[(top + y) * worldW + viewX + x];
+						auto& color = colors[runtime::Snapshot::color(tile) & 7];
+						window.on(color);
+						window.mvaddchar(y, x, runtime::Snapshot::character(tile));
+						window.off(color);
+					}
+				const auto number = frame.info->frame;
+				header.set(0, "Trees:[{:4}]", frame.info->trees);
+				header.set(15, "Year:[{:5}]", frame.info->year);
+				header.set(30, "Position:[{:3}, {:3}]", viewX, viewY);
+				header.set(52, "Cells:[{:6}]", frame.info->cells);
+				header.set(68, "Hash:[{:016x}]", frame.info->hash);
+				if (reader->valid(frame))
+				{
+					lastFrame = number;
+					moved = false;
+					break;
+				}
+			}
+		}
+		screen.draw();
+		/* frames come at most 30 times a second */
+		runtime::wait({STDIN_FILENO}, milliseconds{33});
+	}
+
+	graphics::shutdown();
+	return 0;
+}